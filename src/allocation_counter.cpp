@@ -0,0 +1,24 @@
+#include "peztool/utils/allocation_counter.hpp"
+
+// Only built with the COUNT_ALLOCATIONS CMake option, release builds keep the default allocator
+#ifdef PEZ_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+
+// Counts the allocations of each thread, reported with the CPU usage. Kept out of main.cpp so the
+// compiler does not see that these functions wrap malloc and free.
+void* operator new(size_t const size)
+{
+    pez::AllocationCounter::add();
+    if (void* const ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* const ptr) noexcept
+{
+    std::free(ptr);
+}
+#endif
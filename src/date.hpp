@@ -1,6 +1,10 @@
 #pragma once
 #include <cstdint>
 #include <chrono>
+#include <ctime>
+
+#include "peztool/core/static_interface.hpp"
+#include "peztool/utils/clock.hpp"
 
 struct Date
 {
@@ -39,16 +43,48 @@ struct Date
         return static_cast<float>(hour * 3600 + minute * 60 + second) + static_cast<float>(millisecond) / 1000.0f;
     }
 
+    /// Returns the exact time elapsed since midnight
+    [[nodiscard]]
+    int32_t getTimeAsMilliseconds() const
+    {
+        return ((hour * 60 + minute) * 60 + second) * 1000 + millisecond;
+    }
+
+    [[nodiscard]]
+    bool isSameDay(Date const& other) const
+    {
+        return (year == other.year) && (month == other.month) && (day == other.day);
+    }
+
     [[nodiscard]]
     bool isSame(Date const& other) const
     {
         return (year == other.year) && (month == other.month) && (day == other.day) && (hour == other.hour) && (minute == other.minute) && (second == other.second);
     }
 
-    static Date now()
+    /// Converts this local date to milliseconds since epoch
+    [[nodiscard]]
+    int64_t toEpochMs() const
     {
-        auto const now = std::chrono::system_clock::now();
-        std::time_t now_c = std::chrono::system_clock::to_time_t(now);
+        std::tm local_tm{};
+        local_tm.tm_year  = year - 1900;
+        local_tm.tm_mon   = month - 1;
+        local_tm.tm_mday  = day;
+        local_tm.tm_hour  = hour;
+        local_tm.tm_min   = minute;
+        local_tm.tm_sec   = second;
+        // Let the library figure out if daylight saving applies
+        local_tm.tm_isdst = -1;
+        auto const seconds = static_cast<int64_t>(std::mktime(&local_tm));
+        return seconds * 1000 + millisecond;
+    }
+
+    /// Creates the local date corresponding to a number of milliseconds since epoch
+    static Date fromEpochMs(int64_t const epoch_ms)
+    {
+        // Floor division to handle dates before epoch
+        int64_t const seconds = (epoch_ms >= 0) ? (epoch_ms / 1000) : ((epoch_ms - 999) / 1000);
+        auto const now_c = static_cast<std::time_t>(seconds);
 
         // Platform-specific thread-safe conversion
         std::tm local_tm;
@@ -63,7 +99,27 @@ struct Date
         int32_t const hour = local_tm.tm_hour;
         int32_t const minute = local_tm.tm_min;
         int32_t const second = local_tm.tm_sec;
-        int32_t const ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+        auto const ms = static_cast<int32_t>(epoch_ms - seconds * 1000);
         return {year, month, day, hour, minute, second, ms};
     }
+
+    /// Returns the current time in milliseconds since epoch, from the tick's snapshot if the clock exists
+    static int64_t nowEpochMs()
+    {
+        if (pez::Singleton<pez::Clock>::exists()) {
+            return pez::Singleton<pez::Clock>::get().getEpochMs();
+        }
+        auto const now = std::chrono::system_clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    }
+
+    /// Returns the current local date, from the tick's snapshot if the clock exists
+    static Date now()
+    {
+        if (pez::Singleton<pez::Clock>::exists()) {
+            auto const local = pez::Singleton<pez::Clock>::get().getLocalTime();
+            return {local.year, local.month, local.day, local.hour, local.minute, local.second, local.millisecond};
+        }
+        return fromEpochMs(nowEpochMs());
+    }
 };
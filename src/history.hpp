@@ -1,46 +1,32 @@
 #pragma once
+#include <chrono>
+#include <limits>
 #include <vector>
 
-#include "peztool/utils/binary_io.hpp"
-
 #include "./date.hpp"
+#include "./history_index.hpp"
+#include "./history_journal.hpp"
+#include "./history_parser.hpp"
+#include "./time_series.hpp"
 
 struct History
 {
-    struct TimePoint
-    {
-        Date   date{};
-        size_t activity_idx{0};
-
-        [[nodiscard]]
-        bool isSame(TimePoint const& other) const
-        {
-            return (activity_idx == other.activity_idx) && date.isSame(other.date);
-        }
+    /// Today's entries
+    TimeSeries entries;
 
-        [[nodiscard]]
-        std::string toString() const
-        {
-            return std::format("{} {} {} {} {} {} {}",
-                date.year,
-                date.month,
-                date.day,
-                date.hour,
-                date.minute,
-                date.second,
-                activity_idx
-            );
-        }
-    };
-
-    std::vector<TimePoint> entries;
-
-    History()
+    explicit
+    History(std::chrono::milliseconds const journal_latency = std::chrono::milliseconds{500})
+        : m_journal{getJournalFile(), journal_latency}
     {
+        // Save what a previous session could not before loading today's file
+        recoverJournal();
         entries = load(getCurrentSaveFile());
+        m_saved_count = entries.size();
+        m_index.rebuild(entries);
+        m_day_start_ms = getMidnight();
         // No entry, create the midnight default entry
         if (entries.empty()) {
-            addEntry(getMidnight(), 0);
+            addEntry(m_day_start_ms, 0);
         }
     }
 
@@ -49,49 +35,71 @@ struct History
         saveToFile(getCurrentSaveFile());
     }
 
-    /// Adds a new activity entry in the history
-    void addEntry(Date const& date, size_t const activity_idx)
+    /// Adds a new activity entry in the history, @p time_ms is in milliseconds since epoch
+    void addEntry(int64_t const time_ms, size_t const activity_idx)
     {
         // It's useless to add multiple times the same activity
-        if (!entries.empty() && entries.back().activity_idx == activity_idx) {
+        if (!entries.empty() && entries.activities.back() == activity_idx) {
             return;
         }
-        entries.emplace_back(date, activity_idx);
+        entries.push_back({time_ms, static_cast<uint16_t>(activity_idx)});
+        m_index.onAppend(entries, entries.size() - 1);
+        m_journal.push({time_ms, static_cast<uint32_t>(activity_idx)});
     }
 
-    /// Returns the total duration of the provided activity
+    /// Returns the total duration of the provided activity in milliseconds
     [[nodiscard]]
-    float getDuration(size_t const activity_idx) const
+    int64_t getDurationMs(size_t const activity_idx) const
     {
-        auto const getSlotDuration = [](Date const& start, Date const& end) {
-            return end.getTimeAsSeconds() - start.getTimeAsSeconds();
-        };
-        float result = 0.0f;
-        size_t const activity_count = entries.size();
-        for (size_t i = 0; i < activity_count - 1; ++i) {
-            if (entries[i].activity_idx == activity_idx) {
-                result += getSlotDuration(entries[i].date, entries[i + 1].date);
-            }
-        }
-        if (entries.back().activity_idx == activity_idx) {
-            result += getSlotDuration(entries.back().date, Date::now());
+        int64_t result = m_index.getClosedTotalMs(activity_idx);
+        // Add the ongoing slot
+        if (!entries.empty() && entries.activities.back() == activity_idx) {
+            result += Date::nowEpochMs() - entries.times_ms.back();
         }
         return result;
     }
 
+    /// Returns the time spent on an activity between @p begin_ms and @p end_ms (milliseconds since epoch)
+    [[nodiscard]]
+    int64_t getDurationMs(size_t const activity_idx, int64_t const begin_ms, int64_t const end_ms) const
+    {
+        return m_index.getDurationMs(entries, activity_idx, begin_ms, end_ms, Date::nowEpochMs());
+    }
+
+    /// Returns the slot covering @p time_ms (milliseconds since epoch), if any
+    [[nodiscard]]
+    std::optional<HistoryIndex::Slot> findSlot(int64_t const time_ms) const
+    {
+        return HistoryIndex::findSlot(entries, time_ms, Date::nowEpochMs());
+    }
+
+    /// Returns the total duration of the provided activity in seconds
+    [[nodiscard]]
+    float getDuration(size_t const activity_idx) const
+    {
+        return static_cast<float>(getDurationMs(activity_idx)) * 0.001f;
+    }
+
     /// Given an activity returns its proportion in the day
     [[nodiscard]]
     float getDurationPercent(size_t const activity_idx) const
     {
-        float const current_seconds = Date::now().getTimeAsSeconds();
-        return (getDuration(activity_idx) / current_seconds) * 100.0f;
+        int64_t const day_elapsed_ms = Date::nowEpochMs() - m_day_start_ms;
+        return (static_cast<float>(getDurationMs(activity_idx)) / static_cast<float>(day_elapsed_ms)) * 100.0f;
+    }
+
+    /// Returns the local midnight of the current day in milliseconds since epoch
+    [[nodiscard]]
+    int64_t getDayStart() const
+    {
+        return m_day_start_ms;
     }
 
     /// Returns the index of the last activity
     [[nodiscard]]
     size_t getLastActivityIdx() const
     {
-        return entries.back().activity_idx;
+        return entries.activities.back();
     }
 
     /// Starts a new day that continues the last one
@@ -102,79 +110,72 @@ struct History
         // Use last day's ongoing activity as today's first one
         size_t const first_activity_idx{getLastActivityIdx()};
         entries.clear();
-        addEntry(getMidnight(), first_activity_idx);
+        m_index.clear();
+        m_saved_count = 0;
+        m_day_start_ms = getMidnight();
+        addEntry(m_day_start_ms, first_activity_idx);
     }
 
-    /// Saves the current history to a file
-    void saveToFile(std::string const& filename) const
+    /// Appends the entries that are not saved yet to the provided file
+    void saveToFile(std::string const& filename)
     {
         size_t const entry_count = entries.size();
-        size_t save_from_idx = 0;
-        if (std::filesystem::exists(filename)) {
-            std::cout << "Save found for today, appending" << std::endl;
-            auto const last_data = load(filename).back();
-            for (; save_from_idx < entry_count; ++save_from_idx) {
-                if (entries[save_from_idx].date.getTimeAsSeconds() > last_data.date.getTimeAsSeconds()) {
-                    break;
-                }
-            }
-        } else {
-            std::cout << "No file found, creating a new one" << std::endl;
-        }
-
-        std::cout << "Saving from idx " << save_from_idx << std::endl;
+        std::cout << "Saving from idx " << m_saved_count << std::endl;
         std::ofstream file(filename, std::ios::app);
-        for (size_t i{save_from_idx}; i < entry_count; ++i) {
-            file << entries[i].toString() << '\n';
+        for (size_t i{m_saved_count}; i < entry_count; ++i) {
+            file << toString(entries[i]) << '\n';
         }
         file.close();
+        m_saved_count = entry_count;
+        // Everything is in the text file now, the journal can be discarded
+        m_journal.truncate();
     }
 
     /// Loads a list of entries from the provided @p filename
     [[nodiscard]]
-    static std::vector<TimePoint> load(std::string const& filename)
+    static TimeSeries load(std::string const& filename)
     {
-        std::vector<TimePoint> data;
-
-        std::ifstream file(filename);
-        if (file.is_open()) {
-            std::string line;
-            while (std::getline(file, line)) {
-                auto const time_point = loadFromString(line);
-                if (time_point) {
-                    data.push_back(*time_point);
-                }
-            }
-            file.close();
-        } else {
+        TimeSeries data;
+        if (!std::filesystem::exists(filename)) {
             std::cout << "No save file found for today, a new one will be created." << std::endl;
+            return data;
+        }
+        auto const result = HistoryParser::parseFile(filename, data);
+        if (result.skipped) {
+            std::cout << "Skipped " << result.skipped << " incorrect lines in " << filename << std::endl;
         }
         return data;
     }
 
     /// Creates an Entry for a string
     [[nodiscard]]
-    static std::optional<TimePoint> loadFromString(std::string const& line)
+    static std::optional<TimePoint> loadFromString(std::string_view const line)
     {
-        std::stringstream stream(line);
-
-        int32_t payload;
-        std::vector<int32_t> data;
-
-        // Extract all integers
-        while (stream >> payload) {
-            data.push_back(payload);
-        }
+        HistoryParser::EpochCache cache;
+        return HistoryParser::parseLine(line.data(), line.data() + line.size(), cache);
+    }
 
-        if (data.size() != 7) {
-            std::cout << "Incorrect string, aborting" << std::endl;
-            return std::nullopt;
-        }
+    /// Creates the text representation of an entry, as stored in the save files
+    [[nodiscard]]
+    static std::string toString(TimePoint const& time_point)
+    {
+        Date const date = Date::fromEpochMs(time_point.time_ms);
+        return std::format("{} {} {} {} {} {} {}",
+            date.year,
+            date.month,
+            date.day,
+            date.hour,
+            date.minute,
+            date.second,
+            time_point.activity_idx
+        );
+    }
 
-        TimePoint result;
-        result.date = Date{data[0], data[1], data[2], data[3], data[4], data[5], 0};
-        result.activity_idx = data[6];
-        return result;
+    /// Returns the journal filename
+    [[nodiscard]]
+    static std::string getJournalFile()
+    {
+        return "data/history/journal.bin";
     }
 
     /// Returns the save filename for today
@@ -192,11 +193,62 @@ struct History
     }
 
 private:
+    /// Binary log of the entries added since the last save
+    HistoryJournal m_journal;
+    /// The number of entries already written in the text file
+    size_t m_saved_count{0};
+    /// Local midnight of the current day
+    int64_t m_day_start_ms{0};
+    /// Per-activity slots and duration totals of today's entries
+    HistoryIndex m_index;
+
+    /// Writes to the text files the entries left in the journal by a session that did not exit cleanly
+    void recoverJournal()
+    {
+        auto const records = HistoryJournal::load(getJournalFile());
+        if (records.empty()) {
+            return;
+        }
+        std::cout << "Recovering " << records.size() << " entries from journal" << std::endl;
+
+        // Records are chronological, each run of records from the same day goes to its own file
+        size_t const record_count = records.size();
+        size_t start = 0;
+        while (start < record_count) {
+            Date const day = Date::fromEpochMs(records[start].time_ms);
+            size_t end = start + 1;
+            while (end < record_count && Date::fromEpochMs(records[end].time_ms).isSameDay(day)) {
+                ++end;
+            }
+
+            std::string const filename = getSaveFile(day);
+            // Only keep the records that are more recent than the file content (saved with a 1s resolution)
+            int64_t last_saved_s = std::numeric_limits<int64_t>::min();
+            if (std::filesystem::exists(filename)) {
+                auto const saved = load(filename);
+                if (!saved.empty()) {
+                    last_saved_s = saved.times_ms.back() / 1000;
+                }
+            }
+
+            std::ofstream file(filename, std::ios::app);
+            for (size_t i{start}; i < end; ++i) {
+                if (records[i].time_ms / 1000 > last_saved_s) {
+                    file << toString({records[i].time_ms, static_cast<uint16_t>(records[i].activity_idx)}) << '\n';
+                }
+            }
+            start = end;
+        }
+        m_journal.truncate();
+    }
+
+    /// Returns today's local midnight in milliseconds since epoch
     [[nodiscard]]
-    static Date getMidnight()
+    static int64_t getMidnight()
     {
         Date midnight = Date::now();
         midnight.setTime(0, 0, 0);
-        return midnight;
+        midnight.millisecond = 0;
+        return midnight.toEpochMs();
     }
 };
\ No newline at end of file
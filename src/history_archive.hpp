@@ -0,0 +1,368 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "peztool/utils/binary_io.hpp"
+#include "peztool/utils/mapped_file.hpp"
+#include "peztool/utils/varint.hpp"
+
+#include "./history.hpp"
+
+
+/** Memory mapped pack storing one year of history.
+ *
+ * Layout: a fixed header with the byte offset of each day of the year, followed by the day blobs.
+ * A day blob holds its entry count then, for each entry, the delta with the previous entry's time
+ * (milliseconds since midnight, zigzag varint) and the activity index (varint).
+ * Days are decoded directly from the mapping, nothing is copied or parsed as text.
+ */
+struct HistoryArchive
+{
+    static uint32_t constexpr magic          = 0x4B505454; // "TTPK"
+    static uint32_t constexpr version        = 1;
+    static uint32_t constexpr max_day_count  = 366;
+
+    struct Header
+    {
+        uint32_t magic{};
+        uint32_t version{};
+        int32_t  year{};
+        uint32_t day_count{};
+        /// Offset of each day blob from the start of the file, day i spans [offsets[i], offsets[i + 1])
+        std::array<uint32_t, max_day_count + 1> offsets{};
+    };
+
+    /// One decoded entry, time is relative to the day's midnight
+    struct Entry
+    {
+        int32_t  time_ms{0};
+        uint32_t activity_idx{0};
+
+        bool operator<(Entry const& other) const
+        {
+            return (time_ms < other.time_ms) || (time_ms == other.time_ms && activity_idx < other.activity_idx);
+        }
+
+        bool operator==(Entry const& other) const = default;
+    };
+
+    /// Zero copy view on the entries of one day, entries are decoded while iterating
+    struct DayView
+    {
+        uint8_t const* begin = nullptr;
+        uint8_t const* end   = nullptr;
+
+        [[nodiscard]]
+        uint32_t getCount() const
+        {
+            uint8_t const* cursor = begin;
+            return static_cast<uint32_t>(pez::varint::read(&cursor, end));
+        }
+
+        template<typename TCallback>
+        void foreach(TCallback&& callback) const
+        {
+            uint8_t const* cursor = begin;
+            uint64_t const count = pez::varint::read(&cursor, end);
+            int64_t time_ms = 0;
+            for (uint64_t i{0}; i < count && cursor < end; ++i) {
+                time_ms += pez::varint::readSigned(&cursor, end);
+                auto const activity_idx = static_cast<uint32_t>(pez::varint::read(&cursor, end));
+                callback(Entry{static_cast<int32_t>(time_ms), activity_idx});
+            }
+        }
+    };
+
+    HistoryArchive() = default;
+
+    explicit
+    HistoryArchive(std::filesystem::path const& filepath)
+    {
+        open(filepath);
+    }
+
+    /// Maps the pack and checks its header, returns false if the file is missing or invalid
+    bool open(std::filesystem::path const& filepath)
+    {
+        m_header = nullptr;
+        if (!m_file.open(filepath)) {
+            return false;
+        }
+        if (m_file.size() < sizeof(Header)) {
+            std::cout << "Invalid archive " << filepath << ", file too small" << std::endl;
+            m_file.close();
+            return false;
+        }
+        auto const* header = reinterpret_cast<Header const*>(m_file.data());
+        if (header->magic != magic || header->version != version || header->day_count != max_day_count) {
+            std::cout << "Invalid archive " << filepath << ", unknown format" << std::endl;
+            m_file.close();
+            return false;
+        }
+        // Offsets must be ordered and stay within the file
+        for (uint32_t i{0}; i < max_day_count; ++i) {
+            if (header->offsets[i] > header->offsets[i + 1] || header->offsets[i + 1] > m_file.size()) {
+                std::cout << "Invalid archive " << filepath << ", corrupted index" << std::endl;
+                m_file.close();
+                return false;
+            }
+        }
+        m_header = header;
+        return true;
+    }
+
+    [[nodiscard]]
+    bool isValid() const
+    {
+        return m_header != nullptr;
+    }
+
+    [[nodiscard]]
+    int32_t getYear() const
+    {
+        return m_header ? m_header->year : 0;
+    }
+
+    /// Returns the view of a day from its index in the year (0 is January 1st)
+    [[nodiscard]]
+    DayView getDay(uint32_t const day_idx) const
+    {
+        if (!m_header || day_idx >= max_day_count) {
+            return {};
+        }
+        uint8_t const* const data = m_file.data();
+        return {data + m_header->offsets[day_idx], data + m_header->offsets[day_idx + 1]};
+    }
+
+    /// Calls @p callback(date, view) for each non-empty day of this pack between @p first and @p last (included)
+    template<typename TCallback>
+    void foreachDay(Date const& first, Date const& last, TCallback&& callback) const
+    {
+        if (!m_header) {
+            return;
+        }
+        int32_t const year = m_header->year;
+        if (first.year > year || last.year < year) {
+            return;
+        }
+        // Clamp the range to this pack's year
+        uint32_t const first_idx = (first.year < year) ? 0 : getDayIndex(first);
+        uint32_t const last_idx  = (last.year > year) ? max_day_count - 1 : getDayIndex(last);
+        for (uint32_t i{first_idx}; i <= last_idx && i < max_day_count; ++i) {
+            DayView const view = getDay(i);
+            if (view.begin != view.end) {
+                callback(getDate(year, i), view);
+            }
+        }
+    }
+
+    /// Returns the pack filename for the provided year
+    [[nodiscard]]
+    static std::string getArchiveFile(int32_t const year)
+    {
+        return std::format("data/archive/{}.pack", year);
+    }
+
+    /// Returns the index of the day in its year
+    [[nodiscard]]
+    static uint32_t getDayIndex(Date const& date)
+    {
+        using namespace std::chrono;
+        sys_days const day{year_month_day{year{date.year}, month{static_cast<uint32_t>(date.month)}, std::chrono::day{static_cast<uint32_t>(date.day)}}};
+        sys_days const first_day{year_month_day{year{date.year}, January, std::chrono::day{1}}};
+        return static_cast<uint32_t>((day - first_day).count());
+    }
+
+    /// Returns the date at midnight from a day index in the provided year
+    [[nodiscard]]
+    static Date getDate(int32_t const year, uint32_t const day_idx)
+    {
+        using namespace std::chrono;
+        sys_days const first_day{year_month_day{std::chrono::year{year}, January, day{1}}};
+        year_month_day const date{first_day + days{day_idx}};
+        return {static_cast<int32_t>(date.year()), static_cast<int32_t>(static_cast<uint32_t>(date.month())), static_cast<int32_t>(static_cast<uint32_t>(date.day())), 0, 0, 0, 0};
+    }
+
+    /** Folds the daily text files of finished days into their year pack
+     *
+     * Text files are only removed once the new pack is synced to the disk and moved in place, and
+     * only if they were fully parsed. Files with malformed lines are renamed to .bad, files that
+     * could not be read are left for the next compaction.
+     *
+     * @param history_dir The directory containing the YYYYMMDD.txt files
+     * @param today The current day, its file is still being written and is left untouched
+     */
+    static void compact(std::filesystem::path const& history_dir, Date const& today)
+    {
+        std::map<int32_t, std::vector<std::pair<uint32_t, std::filesystem::path>>> files_per_year;
+        std::error_code error;
+        for (auto const& file : std::filesystem::directory_iterator(history_dir, error)) {
+            auto const date = parseDayFilename(file.path());
+            if (!date || date->isSameDay(today)) {
+                continue;
+            }
+            files_per_year[date->year].emplace_back(getDayIndex(*date), file.path());
+        }
+
+        for (auto const& [year, files] : files_per_year) {
+            compactYear(year, files);
+        }
+    }
+
+private:
+    pez::MappedFile m_file;
+    Header const*   m_header = nullptr;
+
+    using DayEntries = std::array<std::vector<Entry>, max_day_count>;
+
+    static void compactYear(int32_t const year, std::vector<std::pair<uint32_t, std::filesystem::path>> const& files)
+    {
+        std::string const archive_file = getArchiveFile(year);
+        DayEntries days;
+        // Start from the current pack content, the mapping is released before the pack is replaced
+        {
+            HistoryArchive const existing{archive_file};
+            if (existing.isValid()) {
+                for (uint32_t i{0}; i < max_day_count; ++i) {
+                    existing.getDay(i).foreach([&](Entry const& entry) {
+                        days[i].push_back(entry);
+                    });
+                }
+            }
+        }
+
+        size_t parsed_bytes = 0;
+        std::chrono::steady_clock::duration parse_time{};
+        TimeSeries loaded;
+        // Files whose content is entirely in the pack once it is written
+        std::vector<std::filesystem::path> compacted;
+        std::vector<std::filesystem::path> malformed;
+        for (auto const& [day_idx, path] : files) {
+            auto& day = days[day_idx];
+            int64_t const midnight_ms = getDate(year, day_idx).toEpochMs();
+            loaded.clear();
+            auto const parse_start = std::chrono::steady_clock::now();
+            auto const result = HistoryParser::parseFile(path.string(), loaded);
+            parse_time += std::chrono::steady_clock::now() - parse_start;
+            if (!result.read) {
+                std::cout << "Cannot read " << path << ", it is left out of the archive" << std::endl;
+                continue;
+            }
+            parsed_bytes += result.bytes;
+            size_t const entry_count = loaded.size();
+            for (size_t i{0}; i < entry_count; ++i) {
+                auto const time_ms = static_cast<int32_t>(loaded.times_ms[i] - midnight_ms);
+                day.push_back({time_ms, loaded.activities[i]});
+            }
+            // A day can be both in the pack and in a text file if it was recovered after a compaction
+            std::sort(day.begin(), day.end());
+            day.erase(std::unique(day.begin(), day.end()), day.end());
+            if (result.skipped == 0) {
+                compacted.push_back(path);
+            } else {
+                std::cout << "Skipped " << result.skipped << " malformed lines in " << path << std::endl;
+                malformed.push_back(path);
+            }
+        }
+
+        // The pack has to be on the disk before any text file is removed
+        std::string const temporary_file = archive_file + ".tmp";
+        if (!write(temporary_file, year, days) || !pez::syncFile(temporary_file)) {
+            std::cout << "Failed to write archive " << temporary_file << std::endl;
+            return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary_file, archive_file, error);
+        if (error) {
+            std::cout << "Failed to replace archive " << archive_file << ": " << error.message() << std::endl;
+            return;
+        }
+        if (!pez::syncDirectory(std::filesystem::path{archive_file}.parent_path())) {
+            std::cout << "Failed to sync the archive directory, text files are kept" << std::endl;
+            return;
+        }
+        for (auto const& path : compacted) {
+            std::filesystem::remove(path, error);
+        }
+        // Their valid entries are in the pack, the files are kept for a manual check
+        for (auto const& path : malformed) {
+            std::filesystem::path bad_path = path;
+            bad_path += ".bad";
+            std::filesystem::rename(path, bad_path, error);
+        }
+        double const parse_s = std::chrono::duration<double>(parse_time).count();
+        double const throughput_mbs = (parse_s > 0.0) ? (static_cast<double>(parsed_bytes) / parse_s) * 1.0e-6 : 0.0;
+        std::cout << "Compacted " << compacted.size() + malformed.size() << " days into " << archive_file
+                  << " (parsed " << parsed_bytes << " bytes at " << throughput_mbs << " MB/s)" << std::endl;
+    }
+
+    static bool write(std::string const& filename, int32_t const year, DayEntries const& days)
+    {
+        Header header;
+        header.magic     = magic;
+        header.version   = version;
+        header.year      = year;
+        header.day_count = max_day_count;
+
+        std::vector<uint8_t> data;
+        for (uint32_t i{0}; i < max_day_count; ++i) {
+            header.offsets[i] = static_cast<uint32_t>(sizeof(Header) + data.size());
+            auto const& day = days[i];
+            if (day.empty()) {
+                continue;
+            }
+            pez::varint::write(data, day.size());
+            int64_t last_time = 0;
+            for (Entry const& entry : day) {
+                pez::varint::writeSigned(data, entry.time_ms - last_time);
+                pez::varint::write(data, entry.activity_idx);
+                last_time = entry.time_ms;
+            }
+        }
+        header.offsets[max_day_count] = static_cast<uint32_t>(sizeof(Header) + data.size());
+
+        pez::BinaryWriter writer{filename};
+        writer.write(header);
+        writer.writeArray(data.data(), data.size());
+        writer.flush();
+        return writer.outfile.good();
+    }
+
+    /// Extracts the date from a YYYYMMDD.txt filename
+    static std::optional<Date> parseDayFilename(std::filesystem::path const& path)
+    {
+        if (path.extension() != ".txt") {
+            return std::nullopt;
+        }
+        std::string const stem = path.stem().string();
+        if (stem.size() != 8) {
+            return std::nullopt;
+        }
+        auto const readNumber = [&stem](size_t const start, size_t const count) -> std::optional<int32_t> {
+            int32_t value;
+            auto const result = std::from_chars(stem.data() + start, stem.data() + start + count, value);
+            if (result.ec != std::errc() || result.ptr != stem.data() + start + count) {
+                return std::nullopt;
+            }
+            return value;
+        };
+        auto const year  = readNumber(0, 4);
+        auto const month = readNumber(4, 2);
+        auto const day   = readNumber(6, 2);
+        if (!year || !month || !day) {
+            return std::nullopt;
+        }
+        // Rejects the days that do not exist in the month, such as 20240231
+        std::chrono::year_month_day const date{std::chrono::year{*year}, std::chrono::month{static_cast<uint32_t>(*month)}, std::chrono::day{static_cast<uint32_t>(*day)}};
+        if (!date.ok()) {
+            return std::nullopt;
+        }
+        return Date{*year, *month, *day, 0, 0, 0, 0};
+    }
+};
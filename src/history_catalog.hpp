@@ -0,0 +1,241 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "peztool/core/static_interface.hpp"
+#include "peztool/utils/async_task.hpp"
+#include "peztool/utils/thread_pool.hpp"
+
+#include "./history_archive.hpp"
+#include "./history_parser.hpp"
+#include "./timeline_pyramid.hpp"
+
+
+/** The whole recorded history, loaded in the background.
+ *
+ * Sources are the daily text files and the yearly archive packs. Each source is parsed on its own
+ * by the thread pool, then all of them are merged in a single time ordered series.
+ * Sources that are already parsed can be read while the loading is still running.
+ * The merged series is then summarized in a TimelinePyramid to draw long time ranges.
+ */
+struct HistoryCatalog final : pez::AsyncTask
+{
+    /// A file and the entries parsed from it
+    struct Source
+    {
+        std::filesystem::path path;
+        bool                  is_archive{false};
+        TimeSeries            entries;
+        std::atomic<bool>     ready{false};
+    };
+
+    HistoryCatalog(std::filesystem::path history_dir, std::filesystem::path archive_dir)
+        : m_history_dir{std::move(history_dir)}
+        , m_archive_dir{std::move(archive_dir)}
+    {}
+
+    ~HistoryCatalog() override
+    {
+        // The task writes the members below, it has to be finished before they are destroyed
+        waitForCompletion();
+    }
+
+    /** Starts loading in the background, does nothing if a load is already running
+     *
+     * @param pyramid_end_ms The pyramid only covers the entries before this time, usually the start of the current day
+     */
+    void load(int64_t const pyramid_end_ms)
+    {
+        if (!isDone()) {
+            return;
+        }
+        m_pyramid_end_ms = pyramid_end_ms;
+        m_merged = false;
+        m_loaded_count = 0;
+        m_sources.clear();
+        listSources();
+        runTask();
+    }
+
+    /// Returns the proportion of sources already parsed, in [0, 1]
+    [[nodiscard]]
+    float getProgress() const
+    {
+        size_t const source_count = m_sources.size();
+        if (m_merged || source_count == 0) {
+            return 1.0f;
+        }
+        return static_cast<float>(m_loaded_count) / static_cast<float>(source_count);
+    }
+
+    /// Returns true once all the sources are merged in the time ordered series
+    [[nodiscard]]
+    bool isMerged() const
+    {
+        return m_merged;
+    }
+
+    /// Returns all the entries, only valid once isMerged() returns true
+    [[nodiscard]]
+    TimeSeries const& getEntries() const
+    {
+        return m_entries;
+    }
+
+    /// Returns the level of detail pyramid of the entries, only valid once isMerged() returns true
+    [[nodiscard]]
+    TimelinePyramid const& getPyramid() const
+    {
+        return m_pyramid;
+    }
+
+    /// Calls @p callback(entries) for each source already parsed, can be used while loading
+    template<typename TCallback>
+    void foreachLoaded(TCallback&& callback) const
+    {
+        if (m_merged) {
+            callback(m_entries);
+            return;
+        }
+        for (auto const& source : m_sources) {
+            if (source->ready.load(std::memory_order_acquire)) {
+                callback(source->entries);
+            }
+        }
+    }
+
+protected:
+    void task() override
+    {
+        auto const start = std::chrono::steady_clock::now();
+        parseSources();
+        merge();
+        m_pyramid.build(m_entries, m_pyramid_end_ms);
+        m_merged = true;
+        double const elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Loaded " << m_entries.size() << " history entries from " << m_sources.size()
+                  << " files in " << elapsed_s << "s" << std::endl;
+    }
+
+private:
+    std::filesystem::path m_history_dir;
+    std::filesystem::path m_archive_dir;
+
+    /// Sorted by date, owned through pointers since sources hold atomics
+    std::vector<std::unique_ptr<Source>> m_sources;
+    std::atomic<uint32_t>                m_loaded_count{0};
+    std::atomic<bool>                    m_merged{false};
+    TimeSeries                           m_entries;
+    TimelinePyramid                      m_pyramid;
+    int64_t                              m_pyramid_end_ms{0};
+
+    void listSources()
+    {
+        std::error_code error;
+        for (auto const& file : std::filesystem::directory_iterator(m_archive_dir, error)) {
+            if (file.path().extension() == ".pack") {
+                addSource(file.path(), true);
+            }
+        }
+        for (auto const& file : std::filesystem::directory_iterator(m_history_dir, error)) {
+            if (file.path().extension() == ".txt") {
+                addSource(file.path(), false);
+            }
+        }
+        // Packs (YYYY.pack) come before the days (YYYYMMDD.txt) of the same year
+        std::sort(m_sources.begin(), m_sources.end(), [](auto const& a, auto const& b) {
+            return a->path.stem().string() < b->path.stem().string();
+        });
+    }
+
+    void addSource(std::filesystem::path const& path, bool const is_archive)
+    {
+        auto source = std::make_unique<Source>();
+        source->path       = path;
+        source->is_archive = is_archive;
+        m_sources.push_back(std::move(source));
+    }
+
+    void parseSources()
+    {
+        size_t const source_count = m_sources.size();
+        // Sources have very different sizes, one source per chunk so that threads claim them one by one
+        auto const work = [this](size_t const start, size_t const end) {
+            for (size_t i{start}; i < end; ++i) {
+                Source& source = *m_sources[i];
+                if (source.is_archive) {
+                    loadArchive(source.path, source.entries);
+                } else {
+                    HistoryParser::parseFile(source.path.string(), source.entries);
+                }
+                source.ready.store(true, std::memory_order_release);
+                ++m_loaded_count;
+            }
+        };
+
+        if (!pez::Singleton<pez::ThreadPool>::exists()) {
+            work(0, source_count);
+            return;
+        }
+        pez::Singleton<pez::ThreadPool>::get().parallelFor(0, source_count, 1, work);
+    }
+
+    /// Concatenates the sources with a single reservation, sorting only if sources overlap
+    void merge()
+    {
+        size_t const total = std::accumulate(m_sources.begin(), m_sources.end(), size_t{0}, [](size_t const sum, auto const& source) {
+            return sum + source->entries.size();
+        });
+        TimeSeries merged;
+        merged.reserve(total);
+        for (auto const& source : m_sources) {
+            merged.append(source->entries);
+        }
+
+        // A day recovered after its year was compacted can be both in a pack and in a text file
+        if (!std::is_sorted(merged.times_ms.begin(), merged.times_ms.end())) {
+            std::vector<uint32_t> order(total);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&merged](uint32_t const a, uint32_t const b) {
+                return merged.times_ms[a] < merged.times_ms[b];
+            });
+            TimeSeries sorted;
+            sorted.reserve(total);
+            for (uint32_t const idx : order) {
+                TimePoint const time_point = merged[idx];
+                if (sorted.empty() || sorted.times_ms.back() != time_point.time_ms || sorted.activities.back() != time_point.activity_idx) {
+                    sorted.push_back(time_point);
+                }
+            }
+            merged = std::move(sorted);
+        }
+        m_entries = std::move(merged);
+    }
+
+    static void loadArchive(std::filesystem::path const& path, TimeSeries& output)
+    {
+        HistoryArchive const archive{path};
+        if (!archive.isValid()) {
+            return;
+        }
+        int32_t const year = archive.getYear();
+        size_t entry_count = 0;
+        for (uint32_t i{0}; i < HistoryArchive::max_day_count; ++i) {
+            HistoryArchive::DayView const view = archive.getDay(i);
+            if (view.begin != view.end) {
+                entry_count += view.getCount();
+            }
+        }
+        output.reserve(output.size() + entry_count);
+        archive.foreachDay(Date{year, 1, 1, 0, 0, 0, 0}, Date{year, 12, 31, 0, 0, 0, 0}, [&](Date const& date, HistoryArchive::DayView const& view) {
+            int64_t const midnight_ms = date.toEpochMs();
+            view.foreach([&](HistoryArchive::Entry const& entry) {
+                output.push_back({midnight_ms + entry.time_ms, static_cast<uint16_t>(entry.activity_idx)});
+            });
+        });
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "./time_series.hpp"
+
+
+/** Interval index over a chronological TimeSeries.
+ *
+ * Slot i starts at entry i and ends at entry i + 1, the last slot is still open and ends at the
+ * provided current time. Each activity keeps the list of its slots and the prefix sums of their
+ * durations, so point lookups and range totals are binary searches.
+ */
+struct HistoryIndex
+{
+    struct Slot
+    {
+        size_t  entry_idx{0};
+        size_t  activity_idx{0};
+        int64_t start_ms{0};
+        int64_t end_ms{0};
+    };
+
+    void clear()
+    {
+        m_activities.clear();
+    }
+
+    /// Indexes all the entries of @p entries
+    void rebuild(TimeSeries const& entries)
+    {
+        clear();
+        size_t const entry_count = entries.size();
+        for (size_t i{0}; i < entry_count; ++i) {
+            onAppend(entries, i);
+        }
+    }
+
+    /// Indexes the entry @p entry_idx, entries have to be indexed in order
+    void onAppend(TimeSeries const& entries, size_t const entry_idx)
+    {
+        // The new entry closes the previous slot
+        if (entry_idx > 0) {
+            auto& previous = getActivity(entries.activities[entry_idx - 1]);
+            previous.prefix_ms.push_back(previous.prefix_ms.back() + entries.times_ms[entry_idx] - entries.times_ms[entry_idx - 1]);
+        }
+        getActivity(entries.activities[entry_idx]).slots.push_back(static_cast<uint32_t>(entry_idx));
+    }
+
+    /// Returns the total duration of the closed slots of an activity
+    [[nodiscard]]
+    int64_t getClosedTotalMs(size_t const activity_idx) const
+    {
+        return (activity_idx < m_activities.size()) ? m_activities[activity_idx].prefix_ms.back() : 0;
+    }
+
+    /// Returns the slot covering @p time_ms, if any
+    [[nodiscard]]
+    static std::optional<Slot> findSlot(TimeSeries const& entries, int64_t const time_ms, int64_t const now_ms)
+    {
+        auto const& times = entries.times_ms;
+        auto const it = std::upper_bound(times.begin(), times.end(), time_ms);
+        if (it == times.begin()) {
+            return std::nullopt;
+        }
+        auto const entry_idx = static_cast<size_t>(std::distance(times.begin(), it)) - 1;
+        int64_t const end_ms = getSlotEnd(entries, entry_idx, now_ms);
+        if (time_ms >= end_ms) {
+            return std::nullopt;
+        }
+        return Slot{entry_idx, entries.activities[entry_idx], times[entry_idx], end_ms};
+    }
+
+    /// Returns the time spent on an activity between @p begin_ms and @p end_ms
+    [[nodiscard]]
+    int64_t getDurationMs(TimeSeries const& entries, size_t const activity_idx, int64_t const begin_ms, int64_t const end_ms, int64_t const now_ms) const
+    {
+        if (activity_idx >= m_activities.size() || begin_ms >= end_ms) {
+            return 0;
+        }
+        auto const& activity = m_activities[activity_idx];
+        auto const& slots = activity.slots;
+        // Slots do not overlap, both their starts and ends are sorted
+        auto const first = std::partition_point(slots.begin(), slots.end(), [&](uint32_t const entry_idx) {
+            return getSlotEnd(entries, entry_idx, now_ms) <= begin_ms;
+        });
+        auto const last = std::partition_point(first, slots.end(), [&](uint32_t const entry_idx) {
+            return entries.times_ms[entry_idx] < end_ms;
+        });
+        if (first == last) {
+            return 0;
+        }
+
+        auto const first_k = static_cast<size_t>(std::distance(slots.begin(), first));
+        auto const last_k  = static_cast<size_t>(std::distance(slots.begin(), last));
+        size_t const closed_count = activity.prefix_ms.size() - 1;
+        int64_t result = activity.prefix_ms[std::min(last_k, closed_count)] - activity.prefix_ms[std::min(first_k, closed_count)];
+        // The open slot is not in the prefix sums
+        if (closed_count < last_k) {
+            result += now_ms - entries.times_ms[slots[closed_count]];
+        }
+        // Remove the parts of the boundary slots that are outside the range
+        result -= std::max(int64_t{0}, begin_ms - entries.times_ms[*first]);
+        result -= std::max(int64_t{0}, getSlotEnd(entries, *(last - 1), now_ms) - end_ms);
+        return result;
+    }
+
+private:
+    struct ActivitySlots
+    {
+        /// Entry index of each slot of this activity
+        std::vector<uint32_t> slots;
+        /// prefix_ms[k] is the total duration of the first k slots, only closed slots are included
+        std::vector<int64_t>  prefix_ms{0};
+    };
+
+    std::vector<ActivitySlots> m_activities;
+
+    ActivitySlots& getActivity(size_t const activity_idx)
+    {
+        if (activity_idx >= m_activities.size()) {
+            m_activities.resize(activity_idx + 1);
+        }
+        return m_activities[activity_idx];
+    }
+
+    [[nodiscard]]
+    static int64_t getSlotEnd(TimeSeries const& entries, size_t const entry_idx, int64_t const now_ms)
+    {
+        return (entry_idx + 1 < entries.size()) ? entries.times_ms[entry_idx + 1] : now_ms;
+    }
+};
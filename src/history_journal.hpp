@@ -0,0 +1,207 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "peztool/utils/binary_io.hpp"
+
+
+/** Append-only binary log of history entries.
+ *
+ * Records are pushed from the UI thread and written by a background thread that groups
+ * all the records received during the latency budget into a single write and fsync.
+ * The journal only holds entries that are not yet in the daily text files, it is truncated
+ * every time they are saved.
+ */
+struct HistoryJournal
+{
+    /// Fixed size on-disk record
+    struct Record
+    {
+        /// Milliseconds since epoch
+        int64_t  time_ms{0};
+        uint32_t activity_idx{0};
+        uint32_t reserved{0};
+    };
+    static_assert(sizeof(Record) == 16, "Journal records must keep a fixed size");
+
+    HistoryJournal(std::filesystem::path const& filepath, std::chrono::milliseconds const latency_budget)
+        : m_filepath{filepath}
+        , m_latency_budget{latency_budget}
+    {
+        open(true);
+        m_thread = std::thread([this] {
+            run();
+        });
+    }
+
+    ~HistoryJournal()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_stop = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+        closeSync();
+    }
+
+    /// Queues a record, it will be on disk at most after the latency budget
+    void push(Record const& record)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_pending.push_back(record);
+        }
+        m_condition.notify_one();
+    }
+
+    /// Discards the journal content, to be called once all pushed records are saved elsewhere
+    void truncate()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_pending.clear();
+            m_truncate_requested = true;
+        }
+        m_condition.notify_one();
+    }
+
+    /// Reads all the complete records of a journal file, a torn last record is ignored
+    [[nodiscard]]
+    static std::vector<Record> load(std::filesystem::path const& filepath)
+    {
+        std::vector<Record> records;
+        std::error_code error;
+        auto const file_size = std::filesystem::file_size(filepath, error);
+        if (error) {
+            return records;
+        }
+
+        pez::BinaryReader reader{filepath};
+        if (!reader.isValid()) {
+            return records;
+        }
+        records.resize(file_size / sizeof(Record));
+        reader.infile.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        return records;
+    }
+
+private:
+    std::filesystem::path     m_filepath;
+    std::chrono::milliseconds m_latency_budget;
+
+    std::unique_ptr<pez::BinaryWriter> m_writer;
+    int32_t                            m_sync_fd{-1};
+
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    /// Records waiting for the next group commit
+    std::vector<Record>     m_pending;
+    /// Records being written, only accessed by the writer thread
+    std::vector<Record>     m_batch;
+    bool                    m_truncate_requested{false};
+    bool                    m_stop{false};
+
+    void run()
+    {
+        std::unique_lock lock{m_mutex};
+        while (true) {
+            m_condition.wait(lock, [this] {
+                return !m_pending.empty() || m_truncate_requested || m_stop;
+            });
+
+            if (m_truncate_requested) {
+                m_truncate_requested = false;
+                closeSync();
+                open(false);
+            }
+
+            if (!m_pending.empty() && !m_stop) {
+                // Leave some time for other records to join this commit
+                m_condition.wait_for(lock, m_latency_budget, [this] {
+                    return m_stop || m_truncate_requested;
+                });
+                // Records pushed before the truncation are already saved elsewhere
+                if (m_truncate_requested) {
+                    continue;
+                }
+            }
+
+            std::swap(m_pending, m_batch);
+            lock.unlock();
+            commit();
+            lock.lock();
+
+            if (m_stop && m_pending.empty() && !m_truncate_requested) {
+                return;
+            }
+        }
+    }
+
+    /// Writes and syncs the current batch, called without holding the lock
+    void commit()
+    {
+        if (m_batch.empty()) {
+            return;
+        }
+        m_writer->writeArray(m_batch.data(), m_batch.size());
+        m_writer->flush();
+        sync();
+        m_batch.clear();
+    }
+
+    void open(bool const append)
+    {
+        // Reset the writer first to close the file before reopening it
+        m_writer.reset();
+        m_writer = std::make_unique<pez::BinaryWriter>(m_filepath, append);
+        if (!m_writer->outfile) {
+            std::cout << "Cannot open journal file " << m_filepath << std::endl;
+        }
+#ifdef _WIN32
+        m_sync_fd = _open(m_filepath.string().c_str(), _O_RDWR | _O_BINARY);
+#else
+        m_sync_fd = ::open(m_filepath.c_str(), O_RDWR);
+#endif
+    }
+
+    void sync() const
+    {
+        if (m_sync_fd < 0) {
+            return;
+        }
+#ifdef _WIN32
+        _commit(m_sync_fd);
+#else
+        ::fsync(m_sync_fd);
+#endif
+    }
+
+    void closeSync()
+    {
+        if (m_sync_fd < 0) {
+            return;
+        }
+#ifdef _WIN32
+        _close(m_sync_fd);
+#else
+        ::close(m_sync_fd);
+#endif
+        m_sync_fd = -1;
+    }
+};
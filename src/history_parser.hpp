@@ -0,0 +1,189 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HISTORY_PARSER_SSE2
+#endif
+
+#include "./date.hpp"
+#include "./time_series.hpp"
+
+
+/** Bulk parser for the text history files.
+ *
+ * Each line holds "year month day hour minute second activity". The whole file is read in a single
+ * buffer, lines are split with a SIMD newline search and fields are read with std::from_chars, so
+ * parsing does not allocate besides the output reservation.
+ */
+struct HistoryParser
+{
+    struct Result
+    {
+        /// False if the file could not be opened or read
+        bool   read{true};
+        size_t bytes{0};
+        size_t lines{0};
+        size_t skipped{0};
+    };
+
+    /// Converts local dates to epoch milliseconds, calling mktime only when the hour changes
+    struct EpochCache
+    {
+        int32_t year{-1};
+        int32_t month{-1};
+        int32_t day{-1};
+        int32_t hour{-1};
+        int64_t hour_start_ms{0};
+
+        [[nodiscard]]
+        int64_t toEpochMs(std::array<int32_t, 7> const& fields)
+        {
+            if (fields[0] != year || fields[1] != month || fields[2] != day || fields[3] != hour) {
+                year  = fields[0];
+                month = fields[1];
+                day   = fields[2];
+                hour  = fields[3];
+                hour_start_ms = Date{year, month, day, hour, 0, 0, 0}.toEpochMs();
+            }
+            return hour_start_ms + static_cast<int64_t>(fields[4] * 60 + fields[5]) * 1000;
+        }
+    };
+
+    /// Reads the whole file and appends its valid entries to @p output
+    static Result parseFile(std::string const& filename, TimeSeries& output)
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file) {
+            return {false};
+        }
+        auto const size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+        std::string buffer;
+        buffer.resize(size);
+        file.read(buffer.data(), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(file.gcount()) != size) {
+            return {false};
+        }
+        return parse(buffer, output);
+    }
+
+    /// Appends the valid entries of @p text to @p output, malformed lines are skipped
+    static Result parse(std::string_view const text, TimeSeries& output)
+    {
+        Result result;
+        result.bytes = text.size();
+        char const* cursor    = text.data();
+        char const* const end = cursor + text.size();
+        // A single reservation for the whole text
+        output.reserve(output.size() + countLines(cursor, end) + 1);
+
+        EpochCache cache;
+        while (cursor < end) {
+            char const* const line_end = findNewline(cursor, end);
+            auto const time_point = parseLine(cursor, line_end, cache);
+            if (time_point) {
+                output.push_back(*time_point);
+            } else if (!isBlank(cursor, line_end)) {
+                ++result.skipped;
+            }
+            ++result.lines;
+            cursor = line_end + 1;
+        }
+        return result;
+    }
+
+    /// Parses a single line, returns nothing if it does not contain exactly 7 integers
+    [[nodiscard]]
+    static std::optional<TimePoint> parseLine(char const* cursor, char const* const end, EpochCache& cache)
+    {
+        std::array<int32_t, 7> fields{};
+        size_t field_count = 0;
+        while (true) {
+            while (cursor < end && isSpace(*cursor)) {
+                ++cursor;
+            }
+            if (cursor == end) {
+                break;
+            }
+            if (field_count == fields.size()) {
+                return std::nullopt;
+            }
+            auto const conversion = std::from_chars(cursor, end, fields[field_count]);
+            if (conversion.ec != std::errc() || (conversion.ptr < end && !isSpace(*conversion.ptr))) {
+                return std::nullopt;
+            }
+            cursor = conversion.ptr;
+            ++field_count;
+        }
+
+        if (field_count != fields.size()) {
+            return std::nullopt;
+        }
+        return TimePoint{cache.toEpochMs(fields), static_cast<uint16_t>(fields[6])};
+    }
+
+    /// Returns the position of the next '\n', or @p end if there is none
+    [[nodiscard]]
+    static char const* findNewline(char const* cursor, char const* const end)
+    {
+#ifdef HISTORY_PARSER_SSE2
+        __m128i const newline = _mm_set1_epi8('\n');
+        while (end - cursor >= 16) {
+            __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor));
+            auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+            if (mask) {
+                return cursor + std::countr_zero(mask);
+            }
+            cursor += 16;
+        }
+#endif
+        auto const* found = static_cast<char const*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        return found ? found : end;
+    }
+
+    /// Counts the '\n' characters of the range
+    [[nodiscard]]
+    static size_t countLines(char const* cursor, char const* const end)
+    {
+        size_t count = 0;
+#ifdef HISTORY_PARSER_SSE2
+        __m128i const newline = _mm_set1_epi8('\n');
+        while (end - cursor >= 16) {
+            __m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(cursor));
+            auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+            count += std::popcount(mask);
+            cursor += 16;
+        }
+#endif
+        for (; cursor < end; ++cursor) {
+            count += (*cursor == '\n');
+        }
+        return count;
+    }
+
+private:
+    [[nodiscard]]
+    static bool isSpace(char const c)
+    {
+        return (c == ' ') || (c == '\t') || (c == '\r');
+    }
+
+    [[nodiscard]]
+    static bool isBlank(char const* cursor, char const* const end)
+    {
+        for (; cursor < end; ++cursor) {
+            if (!isSpace(*cursor)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
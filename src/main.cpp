@@ -3,6 +3,8 @@
 #include "peztool/peztool.hpp"
 #include "peztool/utils/misc.hpp"
 
+#include "./history_archive.hpp"
+#include "./history_catalog.hpp"
 #include "./scene.hpp"
 #include "./utils.hpp"
 #include "./configuration.hpp"
@@ -17,10 +19,20 @@ int main(int const argc, char* const argv[])
     checkDataDirectory();
     // Create the App
     pez::App app("TimeTracker", conf_filename);
-    pez::Singleton<History>::create();
+    // Maximum time an entry can wait before being written to the journal
+    cload::ConfigurationLoader const loader{conf_filename};
+    auto const journal_latency_ms = loader.tryGetValueAs<int32_t>("journal_latency_ms").value_or(500);
+    pez::Singleton<History>::create(std::chrono::milliseconds{journal_latency_ms});
+    // Fold the files of the previous days into the yearly packs
+    HistoryArchive::compact("data/history", Date::now());
+    // Load the whole history in the background
+    pez::Singleton<HistoryCatalog>::create("data/history", "data/archive");
+    pez::Singleton<HistoryCatalog>::get().load(pez::Singleton<History>::get().getDayStart());
     pez::Singleton<Configuration>::create();
     app.addScene<TimeTracker>();
     // Spin the application until exit requested
     app.run();
+    // The catalog may still be using the thread pool, which is destroyed with the app
+    pez::Singleton<HistoryCatalog>::destroy();
     return 0;
 }
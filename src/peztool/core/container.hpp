@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <typeindex>
 #include "../utils/index_vector.hpp"
 
 namespace pez
@@ -83,10 +84,57 @@ struct EntityPack
     }
 };
 
+/// Declares that a system only reads the entities of type @p TEntity, systems reading the same entities can run concurrently
+template<typename TEntity>
+struct Read
+{
+    using Type = TEntity;
+};
+
+/// Declares that a system modifies the entities of type @p TEntity, this is the default for untagged entities
+template<typename TEntity>
+struct Write
+{
+    using Type = TEntity;
+};
+
+/// Unwraps the access tags used in RequiredEntity
+template<typename T>
+struct EntityAccess
+{
+    using Type = T;
+    static constexpr bool write = true;
+};
+
+template<typename T>
+struct EntityAccess<Read<T>>
+{
+    using Type = T;
+    static constexpr bool write = false;
+};
+
+template<typename T>
+struct EntityAccess<Write<T>>
+{
+    using Type = T;
+    static constexpr bool write = true;
+};
+
+/** The entities used by a system, each entity type can be tagged with Read or Write.
+ *
+ * Tags are only used to schedule the systems, the containers are accessed with the plain entity type.
+ */
 template<typename... TEntities>
 struct RequiredEntity
 {
-    EntityHubView<TEntities...> hub;
+    EntityHubView<typename EntityAccess<TEntities>::Type...> hub;
+
+    /// Calls @p callback(type, write) for each required entity type
+    template<typename TCallback>
+    static void foreachAccess(TCallback&& callback)
+    {
+        (callback(std::type_index{typeid(typename EntityAccess<TEntities>::Type)}, EntityAccess<TEntities>::write), ...);
+    }
 
     template<typename T>
     EntityContainer<T>& getContainer()
@@ -168,5 +216,12 @@ template<typename... TProcessors>
 struct RequiredSystems
 {
     ProcessorHubView<TProcessors...> hub;
+
+    /// Calls @p callback(type) for each required system
+    template<typename TCallback>
+    static void foreachType(TCallback&& callback)
+    {
+        (callback(std::type_index{typeid(TProcessors)}), ...);
+    }
 };
 }
\ No newline at end of file
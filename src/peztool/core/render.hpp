@@ -1,9 +1,12 @@
 #pragma once
 #include <cassert>
+#include <cmath>
 #include "SFML/Graphics.hpp"
 
 #include "../utils/vec.hpp"
 #include "../utils/events.hpp"
+#include "../utils/render/card/card_batch.hpp"
+#include "../utils/render/draw_calls.hpp"
 
 
 namespace pez
@@ -163,19 +166,15 @@ public:
         m_world_layer = registerLayer();
         m_hud_layer = registerLayer();
 
-        float constexpr zoom_factor     = 1.2f;
-        float constexpr zoom_factor_inv = 1.0f / zoom_factor;
+        float constexpr zoom_factor = 1.2f;
         handler.onMouseWheelScrolled([this](sf::Event::MouseWheelScrolled const& event) {
             // Ensure that there is actually a delta (many 0s on MacOS)
             if (event.delta == 0.0f) {
                 return;
             }
+            // Merged scroll events carry the sum of their deltas
             Layer& world_layer = m_layers[m_world_layer];
-            if (event.delta > 0.0f) {
-                world_layer.zoom(zoom_factor);
-            } else {
-                world_layer.zoom(zoom_factor_inv);
-            }
+            world_layer.zoom(std::pow(zoom_factor, event.delta));
         });
 
         handler.onMouseMoved([this](sf::Event::MouseMoved const&) {
@@ -236,6 +235,9 @@ public:
     void clear()
     {
         m_render_texture.clear(m_clear_color);
+        uint64_t const draw_calls = DrawCalls::getCount();
+        m_frame_draw_calls = draw_calls - m_frame_start_draw_calls;
+        m_frame_start_draw_calls = draw_calls;
     }
 
     void renderLayers()
@@ -243,9 +245,17 @@ public:
         m_render_texture.display();
         sf::Sprite const render_sprite{m_render_texture.getTexture()};
         m_window.draw(render_sprite);
+        DrawCalls::add();
         m_window.display();
     }
 
+    /// Returns the number of draw calls counted by DrawCalls during the last frame, a lower bound of the real count
+    [[nodiscard]]
+    uint64_t getFrameDrawCalls() const
+    {
+        return m_frame_draw_calls;
+    }
+
     [[nodiscard]]
     Vec2f getRenderSize() const
     {
@@ -279,6 +289,17 @@ public:
         return m_render_texture.getTexture();
     }
 
+    /** Returns the batch shared by the drawables of the frame to draw their cards together.
+     *
+     * Its vertex buffers are kept between frames. Users flush it before drawing anything else, so
+     * it is empty between two draws of the context.
+     */
+    [[nodiscard]]
+    CardBatch& getCardBatch()
+    {
+        return m_card_batch;
+    }
+
     void setClearColor(sf::Color const color)
     {
         m_clear_color = color;
@@ -318,6 +339,11 @@ private:
     Vec2f m_mouse_position_coef;
     /// The color used to clear the render texture
     sf::Color m_clear_color = sf::Color::Black;
+    /// Shared by the drawables of the frame, see getCardBatch
+    CardBatch m_card_batch;
+    /// Draw calls of the last frame
+    uint64_t m_frame_draw_calls = 0;
+    uint64_t m_frame_start_draw_calls = 0;
 
     void updateMousePosition()
     {
@@ -1,8 +1,11 @@
 #pragma once
+#include "../utils/allocation_counter.hpp"
 #include "../utils/events.hpp"
+#include "../utils/frame_arena.hpp"
 #include "../utils/resources.hpp"
 #include "./container.hpp"
 #include "./render.hpp"
+#include "./system_scheduler.hpp"
 
 namespace pez
 {
@@ -26,16 +29,77 @@ public:
 
     virtual void registerEvents(EventHandler& handler) = 0;
 
+    /** Runs one frame: input, update and render, then display.
+     *
+     * Inputs are processed first so the frame already shows their effects.
+     */
     void tick(float const dt)
     {
+        uint64_t const allocation_count = AllocationCounter::get();
+        // Also dispatches the merged mouse events received while waiting for this frame
+        m_event_handler->processEvents();
         m_render_context->clear();
         onTickInternal(*m_render_context, dt);
         m_render_context->renderLayers();
-        m_event_handler->processEvents();
+        m_event_handler->onFramePresented();
+        // The temporaries of the frame are all released at once
+        if (Singleton<FrameArena>::exists()) {
+            Singleton<FrameArena>::get().reset();
+        }
+        m_frame_allocation_count = AllocationCounter::get() - allocation_count;
+        if constexpr (AllocationCounter::enabled) {
+            checkFrameAllocations();
+        }
     }
 
     virtual void onTickInternal(RenderContext& context, float dt) = 0;
 
+    /// Returns the latencies between input events and the display of the frames showing them
+    [[nodiscard]]
+    LatencyHistogram const& getInputLatency() const
+    {
+        return m_event_handler->getInputLatency();
+    }
+
+    /// Starts a new latency measurement period
+    void clearInputLatency()
+    {
+        m_event_handler->clearInputLatency();
+    }
+
+    /// Processes an event received while the app was waiting for the next frame
+    void processEvent(sf::Event const& event) const
+    {
+        m_event_handler->processEvent(event);
+    }
+
+    /// Returns the number of heap allocations made by the calling thread during the last tick
+    [[nodiscard]]
+    uint64_t getFrameAllocationCount() const
+    {
+        return m_frame_allocation_count;
+    }
+
+    /// Returns the number of frames after the warm up that made heap allocations
+    [[nodiscard]]
+    uint64_t getAllocatingFrameCount() const
+    {
+        return m_allocating_frame_count;
+    }
+
+    /// Returns the execution time of each system during the last frame, processors first then renderers
+    [[nodiscard]]
+    std::vector<SystemTiming> const& getSystemTimings() const
+    {
+        return m_system_timings;
+    }
+
+    [[nodiscard]]
+    EventHandler& getEventHandler() const
+    {
+        return *m_event_handler;
+    }
+
     void setZoom(float const zoom)
     {
         m_render_context->getWorldLayer().setZoom(zoom);
@@ -78,13 +142,30 @@ protected:
     std::unique_ptr<EventHandler>  m_event_handler;
     std::unique_ptr<RenderContext> m_render_context;
     ResourcesStore m_resources;
+    std::vector<SystemTiming> m_system_timings;
 
     bool m_skip_render = false;
 
 private:
     bool m_running = true;
+    uint64_t m_frame_allocation_count = 0;
+    uint64_t m_allocating_frame_count = 0;
+    uint64_t m_tick_count = 0;
 
 private:
+    /// Steady state frames are expected to make no heap allocation, the first one that does is logged
+    void checkFrameAllocations()
+    {
+        if (++m_tick_count <= AllocationCounter::warmup_frame_count || m_frame_allocation_count == 0) {
+            return;
+        }
+        if (m_allocating_frame_count == 0) {
+            std::cout << "[WARNING] Frame " << m_tick_count << " made " << m_frame_allocation_count
+                      << " heap allocations after the warm up" << std::endl;
+        }
+        ++m_allocating_frame_count;
+    }
+
     void registerDefaultEvents() const
     {
         m_event_handler->addCallback<sf::Event::Resized>([this](sf::Event::Resized const)
@@ -95,7 +176,11 @@ private:
 };
 
 
-/// This class stores all the assets declared by the user
+/** This class stores all the assets declared by the user
+ *
+ * Processors run through a SystemScheduler, the ones that do not depend on each other run
+ * concurrently. Renderers run on the calling thread in their declaration order.
+ */
 template<typename TEntitySet, typename TProcessorSet, typename TRendererSet>
 class Scene : public SceneBase
 {
@@ -118,9 +203,10 @@ public:
 private:
     friend class App;
 
-    TEntitySet    m_entities;
-    TProcessorSet m_processors;
-    TRendererSet  m_renderers;
+    TEntitySet      m_entities;
+    TProcessorSet   m_processors;
+    TRendererSet    m_renderers;
+    SystemScheduler m_scheduler;
 
     void onInitializedInternal() override
     {
@@ -140,12 +226,20 @@ private:
     {
         m_clock.restart();
         onTick(dt);
-        std::apply([this, dt](auto&&... args) { (args->updateInternal(dt), ...); }, m_processors.hub);
+        m_scheduler.update(dt);
         std::apply([this](auto&&... args) { (removeEntities(*args), ...); }, m_entities.hub);
         if (!m_skip_render) {
             std::apply([this, &context](auto&&... args) { (args->renderInternal(context), ...); }, m_renderers.hub);
         }
         m_execution_time_us = m_clock.getElapsedTime().asMicroseconds();
+        updateSystemTimings();
+    }
+
+    void updateSystemTimings()
+    {
+        m_scheduler.updateTimings(m_system_timings);
+        size_t i = m_scheduler.getProcessorCount();
+        std::apply([this, &i](auto&&... args) { ((m_system_timings[i++].execution_time_us = args->getExecutionTimeUs()), ...); }, m_renderers.hub);
     }
 
     template<typename TEntity>
@@ -290,6 +384,15 @@ private:
         // Systems are now fully initialized
         std::apply([this](auto&&... args) { (args->onInitialized(), ...); }, m_processors.hub);
         std::apply([this](auto&&... args) { (args->onInitialized(), ...); }, m_renderers.hub);
+        // The execution order only depends on the declarations
+        std::apply([this](auto&&... args) { (m_scheduler.addProcessor(*args), ...); }, m_processors.hub);
+        m_scheduler.build();
+        m_scheduler.addTimings(m_system_timings);
+        // Renderers run one after the other after the last step
+        uint32_t depth = m_scheduler.getStepCount();
+        std::apply([this, &depth](auto&&... args) {
+            (m_system_timings.push_back({SystemScheduler::getTypeName<typename std::decay_t<decltype(args)>::element_type>(), depth++, 0}), ...);
+        }, m_renderers.hub);
     }
 
     /// Profiling clock
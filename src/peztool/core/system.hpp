@@ -6,6 +6,7 @@
 #include "./container.hpp"
 #include "./render.hpp"
 #include "./scene.hpp"
+#include "./system_scheduler.hpp"
 #include "./entity.hpp"
 
 namespace pez
@@ -22,6 +23,9 @@ private:
     TRequiredRenderers m_renderers;
 
 public:
+    using RequiredEntities   = TRequiredEntity;
+    using RequiredProcessors = TRequiredProcessor;
+
     virtual ~System() = default;
 
     void setScene(SceneBase* scene)
@@ -156,8 +160,8 @@ protected:
         auto const count = data.size();
 
         auto& tp{Singleton<ThreadPool>::get()};
-        tp.dispatch(count, [&data, callback](uint32_t const start, uint32_t const end) {
-            for (uint32_t i{start}; i < end; ++i) {
+        tp.parallelFor(0, count, 0, [&data, &callback](size_t const start, size_t const end) {
+            for (size_t i{start}; i < end; ++i) {
                 if (!data[i].removeRequested()) {
                     callback(i, data[i]);
                 }
@@ -172,8 +176,8 @@ protected:
         auto const count = data.size();
 
         auto& tp{Singleton<ThreadPool>::get()};
-        tp.dispatch(count, [&data, callback](uint32_t const start, uint32_t const end) {
-            for (uint32_t i{start}; i < end; ++i) {
+        tp.parallelFor(0, count, 0, [&data, &callback](size_t const start, size_t const end) {
+            for (size_t i{start}; i < end; ++i) {
                 if (!data[i].removeRequested()) {
                     callback(data[i]);
                 }
@@ -209,12 +213,30 @@ protected:
         m_execution_time_us = m_clock.getElapsedTime().asMicroseconds();
     }
 
+    /** Calls the subscribers of the signal right away.
+     *
+     * Subscribers and the dispatcher are not thread safe, so when the system runs concurrently with
+     * others the signal is posted instead and delivered at the start of the next tick.
+     */
     template<typename TSignal, typename... TArgs>
     void emit(TArgs&&... args)
     {
+        if (SystemScheduler::isParallelStepRunning()) {
+            if (!post<TSignal>(std::forward<TArgs>(args)...)) {
+                std::cout << "[WARNING] Signal queue full, a signal emitted by a concurrent system was dropped" << std::endl;
+            }
+            return;
+        }
         Dispatcher<TSignal>::emit(TSignal{std::forward<TArgs>(args)...});
     }
 
+    /// Queues a signal delivered at the start of the next tick, safe to call from parallel loops
+    template<typename TSignal, typename... TArgs>
+    bool post(TArgs&&... args)
+    {
+        return Dispatcher<TSignal>::post(TSignal{std::forward<TArgs>(args)...});
+    }
+
     template<typename TSignal, typename TSub>
     void subscribe(TSub* subscriber)
     {
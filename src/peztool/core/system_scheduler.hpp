@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "../utils/dag.hpp"
+#include "../utils/thread_pool.hpp"
+#include "./static_interface.hpp"
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+
+namespace pez
+{
+
+/// The execution time of a system during the last frame
+struct SystemTiming
+{
+    std::string name;
+    /// Systems with the same depth ran concurrently
+    uint32_t    depth             = 0;
+    size_t      execution_time_us = 0;
+};
+
+/** Runs the processors of a scene in an order that respects their declared dependencies.
+ *
+ * A system runs after the processors it requires, wherever they are declared, and after the earlier
+ * declared systems that access the same entities, unless both only read them. If the requirements
+ * form a cycle, all the systems run one after the other in declaration order. Systems end up in a DAG whose depth gives
+ * the step in which they run, systems of the same step run concurrently on the thread pool.
+ * Signals emitted during a concurrent step are posted instead, see System::emit.
+ */
+struct SystemScheduler
+{
+    struct Node
+    {
+        std::string                                   name;
+        std::type_index                               type;
+        std::vector<std::type_index>                  required_systems;
+        /// The entity types accessed by the system and whether they are written
+        std::vector<std::pair<std::type_index, bool>> entities;
+        std::function<void(float)>                    update;
+        std::function<size_t()>                       getExecutionTimeUs;
+    };
+
+    /// Adds a processor, processors have to be added in their declaration order
+    template<typename TProcessor>
+    void addProcessor(TProcessor& processor)
+    {
+        Node node{getTypeName<TProcessor>(), std::type_index{typeid(TProcessor)}, {}, {}, {}, {}};
+        TProcessor::RequiredProcessors::foreachType([&node](std::type_index const type) {
+            node.required_systems.push_back(type);
+        });
+        TProcessor::RequiredEntities::foreachAccess([&node](std::type_index const type, bool const write) {
+            node.entities.emplace_back(type, write);
+        });
+        node.update = [&processor](float const dt) {
+            processor.updateInternal(dt);
+        };
+        node.getExecutionTimeUs = [&processor] {
+            return processor.getExecutionTimeUs();
+        };
+        m_nodes.push_back(std::move(node));
+    }
+
+    /// Creates the DAG and the steps, to call once all the processors are added
+    void build()
+    {
+        size_t const node_count = m_nodes.size();
+        resetDAG();
+        // Each pair is visited once so edges are never duplicated, they skip the checks of DAG::createConnection.
+        // Conflicting systems keep the declaration order, unless the earlier one requires the later one
+        for (uint32_t i{0}; i < node_count; ++i) {
+            for (uint32_t k{i + 1}; k < node_count; ++k) {
+                bool const requires_later = dependsOn(m_nodes[i], m_nodes[k]);
+                if (requires_later) {
+                    addEdge(k, i);
+                }
+                if (dependsOn(m_nodes[k], m_nodes[i]) || (!requires_later && conflicts(m_nodes[i], m_nodes[k]))) {
+                    addEdge(i, k);
+                }
+            }
+        }
+        if (hasCycle()) {
+            std::cout << "[ERROR] Cyclic processor requirements, processors will run in declaration order" << std::endl;
+            resetDAG();
+            for (uint32_t i{1}; i < node_count; ++i) {
+                addEdge(i - 1, i);
+            }
+        }
+        m_dag.computeDepth();
+
+        m_steps.clear();
+        for (uint32_t const node_idx : m_dag.getOrder()) {
+            uint32_t const depth = m_dag.nodes[node_idx].depth;
+            if (depth >= m_steps.size()) {
+                m_steps.resize(depth + 1);
+            }
+            m_steps[depth].push_back(node_idx);
+        }
+    }
+
+    /// Runs all the processors, waits for each step before starting the next one
+    void update(float const dt)
+    {
+        bool const parallel = Singleton<ThreadPool>::exists();
+        for (std::vector<uint32_t> const& step : m_steps) {
+            if (step.size() == 1 || !parallel) {
+                for (uint32_t const node_idx : step) {
+                    m_nodes[node_idx].update(dt);
+                }
+                continue;
+            }
+            s_parallel_step.store(true, std::memory_order_relaxed);
+            Singleton<ThreadPool>::get().parallelFor(0, step.size(), 1, [this, &step, dt](size_t const start, size_t const end) {
+                for (size_t i{start}; i < end; ++i) {
+                    m_nodes[step[i]].update(dt);
+                }
+            });
+            s_parallel_step.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    /// Returns true while the systems of a step run concurrently, the caller thread included
+    [[nodiscard]]
+    static bool isParallelStepRunning()
+    {
+        return s_parallel_step.load(std::memory_order_relaxed);
+    }
+
+    /// Appends one timing per processor to @p timings, in declaration order
+    void addTimings(std::vector<SystemTiming>& timings) const
+    {
+        uint32_t i{0};
+        for (Node const& node : m_nodes) {
+            timings.push_back({node.name, m_dag.nodes[i].depth, node.getExecutionTimeUs()});
+            ++i;
+        }
+    }
+
+    /// Updates the execution times of the timings created by addTimings
+    void updateTimings(std::vector<SystemTiming>& timings) const
+    {
+        size_t const node_count = m_nodes.size();
+        for (size_t i{0}; i < node_count; ++i) {
+            timings[i].execution_time_us = m_nodes[i].getExecutionTimeUs();
+        }
+    }
+
+    [[nodiscard]]
+    size_t getProcessorCount() const
+    {
+        return m_nodes.size();
+    }
+
+    /// Returns the number of steps, the renderers run after them
+    [[nodiscard]]
+    uint32_t getStepCount() const
+    {
+        return static_cast<uint32_t>(m_steps.size());
+    }
+
+    template<typename T>
+    [[nodiscard]]
+    static std::string getTypeName()
+    {
+        char const* name = typeid(T).name();
+#if defined(__GNUG__)
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        if (status == 0 && demangled) {
+            std::string result{demangled};
+            std::free(demangled);
+            return result;
+        }
+#endif
+        return name;
+    }
+
+private:
+    /// Set by the main thread around the concurrent steps, the tasks of the step see it through the pool's locks
+    static inline std::atomic<bool> s_parallel_step{false};
+
+    std::vector<Node>                  m_nodes;
+    DAG<uint32_t>                      m_dag;
+    /// The nodes of each depth of the DAG
+    std::vector<std::vector<uint32_t>> m_steps;
+
+    void resetDAG()
+    {
+        m_dag = {};
+        for (size_t i{0}; i < m_nodes.size(); ++i) {
+            m_dag.createNode();
+        }
+    }
+
+    void addEdge(uint32_t const from, uint32_t const to)
+    {
+        m_dag.nodes[from].out.push_back(to);
+        ++m_dag.nodes[to].incoming;
+    }
+
+    /// Returns true if some nodes can never be reached by removing the nodes without incoming edges
+    [[nodiscard]]
+    bool hasCycle() const
+    {
+        size_t const node_count = m_nodes.size();
+        std::vector<uint32_t> incoming(node_count);
+        std::vector<uint32_t> ready;
+        for (uint32_t i{0}; i < node_count; ++i) {
+            incoming[i] = m_dag.nodes[i].incoming;
+            if (incoming[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+        size_t sorted_count = 0;
+        while (!ready.empty()) {
+            uint32_t const node_idx = ready.back();
+            ready.pop_back();
+            ++sorted_count;
+            for (uint32_t const child : m_dag.nodes[node_idx].out) {
+                if (--incoming[child] == 0) {
+                    ready.push_back(child);
+                }
+            }
+        }
+        return sorted_count != node_count;
+    }
+
+    [[nodiscard]]
+    static bool dependsOn(Node const& node, Node const& other)
+    {
+        return std::find(node.required_systems.begin(), node.required_systems.end(), other.type) != node.required_systems.end();
+    }
+
+    [[nodiscard]]
+    static bool conflicts(Node const& a, Node const& b)
+    {
+        for (auto const& [type_a, write_a] : a.entities) {
+            for (auto const& [type_b, write_b] : b.entities) {
+                if (type_a == type_b && (write_a || write_b)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+}
@@ -1,8 +1,14 @@
 #pragma once
+#include <cmath>
 #include <SFML/Graphics.hpp>
 
 #include "peztool/core/scene.hpp"
 #include "peztool/core/static_interface.hpp"
+#include "peztool/utils/clock.hpp"
+#include "peztool/utils/cpu_usage.hpp"
+#include "peztool/utils/frame_arena.hpp"
+#include "peztool/utils/frame_scheduler.hpp"
+#include "peztool/utils/signal.hpp"
 #include "peztool/utils/thread_pool.hpp"
 #include "peztool/utils/configuration_loader.hpp"
 
@@ -24,6 +30,15 @@ public:
 
         // Create default singletons
         GlobalInstance<App>::instance = this;
+        Singleton<Clock>::create();
+        Singleton<ThreadPool>::create(m_thread_count);
+        Singleton<FrameArena>::create(m_frame_arena_capacity);
+    }
+
+    ~App()
+    {
+        Singleton<FrameArena>::destroy();
+        Singleton<ThreadPool>::destroy();
     }
 
     void setTickRate(uint32_t const tick_rate, bool const sync_window_frame_limit)
@@ -49,7 +64,11 @@ public:
     void run()
     {
         while (m_window.isOpen()) {
+            if (m_event_driven) {
+                waitForFrame();
+            }
             tick(m_dt);
+            reportCpuUsage();
         }
     }
 
@@ -61,6 +80,11 @@ public:
 
     void tick(float const dt)
     {
+        // All the time reads of this tick will use this snapshot
+        Singleton<Clock>::get().update();
+        m_scheduler.onFrame(Singleton<Clock>::get().getSteadyNs());
+        // Signals posted by other threads since the last tick
+        SignalQueues::flush();
         if (m_current_scene) {
             m_current_scene->setRunning(m_running);
             m_current_scene->tick(dt);
@@ -89,6 +113,8 @@ public:
         static_assert(std::is_base_of_v<SceneBase, TScene>);
         m_current_scene = std::make_unique<TScene>(std::forward<TArgs>(args)...);;
         m_current_scene->initialize(m_window, m_render_size);
+        m_current_scene->getEventHandler().setCoalescing(m_coalesce_mouse_events);
+        m_report_start_events = {};
         return dynamic_cast<TScene&>(*m_current_scene);
     }
 
@@ -147,6 +173,43 @@ public:
         return GlobalInstance<App>::instance->m_frame_rate_unlocked;
     }
 
+    /// Returns the clock holding this tick's time snapshot
+    static Clock& getClock()
+    {
+        return Singleton<Clock>::get();
+    }
+
+    /// Asks for a new frame as soon as possible
+    static void requestFrame()
+    {
+        GlobalInstance<App>::instance->m_scheduler.requestFrame();
+    }
+
+    /// Asks for a frame in @p delay seconds of wall time
+    static void requestFrameIn(float const delay)
+    {
+        auto const& clock = Singleton<Clock>::get();
+        GlobalInstance<App>::instance->m_scheduler.requestFrameAt(clock.getSteadyNs() + static_cast<int64_t>(delay * 1.0e9f));
+    }
+
+    /** Asks for continuous frames while an animation runs
+     *
+     * @param duration The animation's duration in seconds
+     * @param wall_time If true the duration is in wall time, else in app time (advancing by dt each tick)
+     */
+    static void requestAnimation(float const duration, bool const wall_time)
+    {
+        App& app = *GlobalInstance<App>::instance;
+        if (wall_time) {
+            auto const& clock = Singleton<Clock>::get();
+            app.m_scheduler.requestFramesUntil(clock.getSteadyNs() + static_cast<int64_t>(duration * 1.0e9f));
+        } else {
+            // One more tick to render the final value
+            auto const tick_count = static_cast<uint64_t>(std::ceil(duration / app.m_dt)) + 1;
+            app.m_scheduler.requestFramesUntilTick(app.m_tick + tick_count);
+        }
+    }
+
     static ThreadPool& getThreadPool()
     {
         return Singleton<ThreadPool>::get();
@@ -185,6 +248,24 @@ private:
     bool m_running = true;
     bool m_frame_rate_unlocked = false;
 
+    /// If true, frames are only rendered when requested or when an event is received
+    bool           m_event_driven = true;
+    FrameScheduler m_scheduler;
+    /// Period of the CPU usage report in seconds, 0 to disable it
+    float          m_cpu_report_period = 0.0f;
+    CpuUsage       m_cpu_usage;
+    uint64_t       m_report_start_draw_calls = 0;
+    /// Received and dispatched event counts at the start of the report period
+    std::pair<uint64_t, uint64_t> m_report_start_events;
+    /// Merge bursts of mouse moves and wheel scrolls in one event per frame
+    bool           m_coalesce_mouse_events = false;
+    /// Number of workers of the thread pool
+    uint32_t       m_thread_count = 1;
+    /// Initial size in bytes of the frame arena, it grows if a frame needs more
+    size_t         m_frame_arena_capacity = FrameArena::default_capacity;
+    /// Heap allocations of the main thread during the ticks of the report period
+    uint64_t       m_report_allocation_count = 0;
+
     std::unique_ptr<SceneBase> m_current_scene = nullptr;
 
     /// Reads configuration file and sets the app accordingly
@@ -204,6 +285,87 @@ private:
         settings.antiAliasingLevel = 8;
         // Create the window
         m_window.create(sf::VideoMode{{window_size.x, window_size.y}}, "", sf::Style::Default, state, settings);
+        // Rendering mode
+        m_event_driven      = loader.tryGetValueAs<bool>("event_driven_rendering").value_or(true);
+        m_cpu_report_period = loader.tryGetValueAs<float>("cpu_usage_report_period").value_or(0.0f);
+        m_coalesce_mouse_events = loader.tryGetValueAs<bool>("coalesce_mouse_events").value_or(false);
+        // Idle workers are parked, they only use CPU when tasks are added
+        m_thread_count = loader.tryGetValueAs<uint32_t>("thread_count").value_or(std::max(1u, std::thread::hardware_concurrency()));
+        m_frame_arena_capacity = loader.tryGetValueAs<size_t>("frame_arena_size").value_or(FrameArena::default_capacity);
+    }
+
+    /// Sleeps until the next frame is due, events received meanwhile are processed
+    void waitForFrame()
+    {
+        auto& clock = Singleton<Clock>::get();
+        while (m_window.isOpen()) {
+            clock.update();
+            int64_t const wait_ns = m_scheduler.getWaitNs(clock.getSteadyNs(), m_tick);
+            if (wait_ns == 0) {
+                return;
+            }
+            // Zero means no timeout for SFML, the wait is at least 1us
+            sf::Time const timeout = (wait_ns == FrameScheduler::no_deadline) ? sf::Time::Zero : sf::microseconds(std::max(int64_t{1}, wait_ns / 1000));
+            if (std::optional<sf::Event> const event = m_window.waitEvent(timeout)) {
+                // The wait can last up to a second, callbacks must see the time of the event
+                clock.update();
+                if (m_current_scene) {
+                    m_current_scene->processEvent(*event);
+                }
+                m_scheduler.requestFrame();
+            }
+        }
+    }
+
+    void reportCpuUsage()
+    {
+        if (m_cpu_report_period <= 0.0f) {
+            return;
+        }
+        m_cpu_usage.addFrame();
+        if (m_current_scene) {
+            m_report_allocation_count += m_current_scene->getFrameAllocationCount();
+        }
+        if (m_cpu_usage.getElapsedSeconds() >= m_cpu_report_period) {
+            uint64_t const draw_calls = DrawCalls::getCount() - m_report_start_draw_calls;
+            std::pair<uint64_t, uint64_t> events{};
+            if (m_current_scene) {
+                EventHandler const& handler = m_current_scene->getEventHandler();
+                events = {handler.getReceivedCount(), handler.getDispatchedCount()};
+            }
+            double const elapsed = m_cpu_usage.getElapsedSeconds();
+            std::cout << "[" << (m_event_driven ? "event driven" : "continuous") << "] CPU usage: "
+                      << m_cpu_usage.getUsage() * 100.0 << "% of one core, "
+                      << m_cpu_usage.getFrameRate() << " frames/s, "
+                      << static_cast<double>(draw_calls) / static_cast<double>(std::max(m_cpu_usage.getFrameCount(), uint64_t{1}))
+                      << " tracked draw calls/frame, "
+                      << static_cast<double>(events.first - m_report_start_events.first) / elapsed << " events/s received, "
+                      << static_cast<double>(events.second - m_report_start_events.second) / elapsed << " dispatched" << std::endl;
+            if (m_current_scene) {
+                LatencyHistogram const& latency = m_current_scene->getInputLatency();
+                std::cout << "Input to display latency: " << latency.getMeanMs() << "ms mean, "
+                          << latency.getPercentileMs(0.5) << "ms p50, "
+                          << latency.getPercentileMs(0.99) << "ms p99, "
+                          << latency.getMaxMs() << "ms max over " << latency.getCount() << " inputs" << std::endl;
+                // Per period, like the other metrics
+                m_current_scene->clearInputLatency();
+                FrameArena const& arena = Singleton<FrameArena>::get();
+                if constexpr (AllocationCounter::enabled) {
+                    std::cout << "Heap allocations: " << static_cast<double>(m_report_allocation_count) / static_cast<double>(std::max(m_cpu_usage.getFrameCount(), uint64_t{1}))
+                              << "/frame, " << m_current_scene->getAllocatingFrameCount() << " allocating frames after the warm up, ";
+                }
+                std::cout << "frame arena peak " << arena.getPeakUsed() << " of " << arena.getCapacity() << " bytes" << std::endl;
+                // Systems of the same step ran concurrently
+                for (SystemTiming const& timing : m_current_scene->getSystemTimings()) {
+                    std::cout << "  [step " << timing.depth << "] " << timing.name << ": "
+                              << static_cast<double>(timing.execution_time_us) * 0.001 << "ms" << std::endl;
+                }
+            }
+            m_cpu_usage.restart();
+            m_report_start_draw_calls = DrawCalls::getCount();
+            m_report_start_events = events;
+            m_report_allocation_count = 0;
+        }
     }
 };
 
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+
+namespace pez
+{
+
+/** Counts the heap allocations made by the current thread.
+ *
+ * The count only moves in builds with PEZ_COUNT_ALLOCATIONS, where the global operator new calls
+ * add(), see allocation_counter.cpp. Used to check that steady state frames do not allocate.
+ */
+struct AllocationCounter
+{
+#ifdef PEZ_COUNT_ALLOCATIONS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    /// Frames at the start of a scene that may allocate while caches and arenas grow
+    static constexpr uint64_t warmup_frame_count = 120;
+
+    static void add()
+    {
+        ++s_count;
+    }
+
+    [[nodiscard]]
+    static uint64_t get()
+    {
+        return s_count;
+    }
+
+private:
+    /// Constant initialized, so it can be used by allocations made before main
+    static inline thread_local uint64_t s_count = 0;
+};
+
+}
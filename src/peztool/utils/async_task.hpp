@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <functional>
 #include <future>
 
@@ -13,9 +14,7 @@ public:
 
     virtual ~AsyncTask()
     {
-        if (m_running) {
-            m_future.wait();
-        }
+        waitForCompletion();
     }
 
     [[nodiscard]]
@@ -37,23 +36,22 @@ public:
 protected:
     void runTask()
     {
-        // Don't allow multiple concurrent runs
-        if (m_running) {
+        // Don't allow multiple concurrent runs, the flag is set before the thread starts so isDone() is false right away
+        if (m_running.exchange(true)) {
             return;
         }
 
         m_future = std::async(std::launch::async, [this]{
             m_updated = true;
-            m_running = true;
             task();
             m_running = false;
         });
     }
 
-    /// Blocks until the task is done
+    /// Blocks until the task is done, derived classes call it in their destructor before their members are destroyed
     void waitForCompletion() const
     {
-        if (m_running) {
+        if (m_future.valid()) {
             m_future.wait();
         }
     }
@@ -63,8 +61,8 @@ protected:
 private:
     std::future<void>     m_future;
     std::function<void()> m_task;
-    bool                  m_updated{true};
-    bool                  m_running{false};
+    std::atomic<bool>     m_updated{true};
+    std::atomic<bool>     m_running{false};
 };
 
 }
\ No newline at end of file
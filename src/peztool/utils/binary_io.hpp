@@ -1,16 +1,62 @@
 #pragma once
 
+#include <filesystem>
 #include <fstream>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace pez
 {
+/// Asks the OS to write the file content to the disk, returns false if it could not be done
+inline bool syncFile(std::filesystem::path const& filepath)
+{
+#ifdef _WIN32
+    int const fd = _open(filepath.string().c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0) {
+        return false;
+    }
+    bool const synced = _commit(fd) == 0;
+    _close(fd);
+#else
+    int const fd = ::open(filepath.c_str(), O_RDWR);
+    if (fd < 0) {
+        return false;
+    }
+    bool const synced = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return synced;
+}
+
+/// Makes the creations, renames and deletions of files in @p directory durable, Windows has no equivalent
+inline bool syncDirectory(std::filesystem::path const& directory)
+{
+#ifdef _WIN32
+    return true;
+#else
+    int const fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool const synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
 struct BinaryWriter
 {
     std::ofstream outfile;
 
     explicit
-    BinaryWriter(const std::filesystem::path& filepath)
-        : outfile{filepath, std::istream::out | std::ios::binary}
+    BinaryWriter(const std::filesystem::path& filepath, bool const append = false)
+        : outfile{filepath, std::istream::out | std::ios::binary | (append ? std::ios::app : std::ios::openmode{})}
     {}
 
     ~BinaryWriter()
@@ -31,6 +77,24 @@ struct BinaryWriter
     {
         outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
     }
+
+    /** Dumps a contiguous range of values as a single binary blob
+     *
+     * @tparam TValue The values' type
+     * @param values Pointer to the first value
+     * @param count The number of values to dump
+     */
+    template<typename TValue>
+    void writeArray(const TValue* values, size_t const count)
+    {
+        outfile.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(sizeof(TValue) * count));
+    }
+
+    /// Pushes buffered data to the OS
+    void flush()
+    {
+        outfile.flush();
+    }
 };
 
 struct BinaryReader
@@ -0,0 +1,222 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+
+namespace pez
+{
+
+/// Provides the raw time samples, can be replaced to control time in benchmarks
+struct ClockSource
+{
+    virtual ~ClockSource() = default;
+
+    /// Wall time in milliseconds since epoch
+    [[nodiscard]]
+    virtual int64_t getSystemMs() const = 0;
+
+    /// Monotonic time in nanoseconds
+    [[nodiscard]]
+    virtual int64_t getSteadyNs() const = 0;
+};
+
+struct SystemClockSource final : ClockSource
+{
+    [[nodiscard]]
+    int64_t getSystemMs() const override
+    {
+        auto const now = std::chrono::system_clock::now();
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    }
+
+    [[nodiscard]]
+    int64_t getSteadyNs() const override
+    {
+        auto const now = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    }
+};
+
+/// Time only moves when asked to
+struct VirtualClockSource final : ClockSource
+{
+    int64_t system_ms{0};
+    int64_t steady_ns{0};
+
+    explicit
+    VirtualClockSource(int64_t const start_system_ms)
+        : system_ms{start_system_ms}
+    {}
+
+    void advance(int64_t const dt_ms)
+    {
+        system_ms += dt_ms;
+        steady_ns += dt_ms * 1000000;
+    }
+
+    [[nodiscard]]
+    int64_t getSystemMs() const override
+    {
+        return system_ms;
+    }
+
+    [[nodiscard]]
+    int64_t getSteadyNs() const override
+    {
+        return steady_ns;
+    }
+};
+
+/** Wall and monotonic time sampled once per tick.
+ *
+ * All the reads during a tick return the same snapshot. The local calendar date and hour are
+ * cached, libc is only called when the snapshot leaves the cached hour, the rest of the civil
+ * time is integer math.
+ */
+struct Clock
+{
+    struct LocalTime
+    {
+        int32_t year{0};
+        int32_t month{0};
+        int32_t day{0};
+        int32_t hour{0};
+        int32_t minute{0};
+        int32_t second{0};
+        int32_t millisecond{0};
+    };
+
+    Clock()
+        : m_source{std::make_unique<SystemClockSource>()}
+    {
+        update();
+    }
+
+    /// Replaces the time source, for instance with a VirtualClockSource
+    void setSource(std::unique_ptr<ClockSource> source)
+    {
+        m_source = std::move(source);
+        m_hour_start_ms = 0;
+        m_hour_end_ms   = 0;
+        m_midnight_ms   = 0;
+        m_next_midnight_ms = 0;
+        update();
+    }
+
+    /// Takes a new snapshot, to be called once per tick
+    void update()
+    {
+        m_epoch_ms  = m_source->getSystemMs();
+        m_steady_ns = m_source->getSteadyNs();
+        if (m_epoch_ms < m_hour_start_ms || m_epoch_ms >= m_hour_end_ms) {
+            updateHour();
+        }
+        if (m_epoch_ms < m_midnight_ms || m_epoch_ms >= m_next_midnight_ms) {
+            updateDay();
+        }
+    }
+
+    /// Returns the snapshot's wall time in milliseconds since epoch
+    [[nodiscard]]
+    int64_t getEpochMs() const
+    {
+        return m_epoch_ms;
+    }
+
+    /// Returns the snapshot's monotonic time in nanoseconds
+    [[nodiscard]]
+    int64_t getSteadyNs() const
+    {
+        return m_steady_ns;
+    }
+
+    /// Returns the last local midnight in milliseconds since epoch
+    [[nodiscard]]
+    int64_t getMidnightMs() const
+    {
+        return m_midnight_ms;
+    }
+
+    /// Returns the wall time elapsed since the last local midnight
+    [[nodiscard]]
+    int64_t getMsSinceMidnight() const
+    {
+        return m_epoch_ms - m_midnight_ms;
+    }
+
+    /// Returns the snapshot in local civil time
+    [[nodiscard]]
+    LocalTime getLocalTime() const
+    {
+        LocalTime result = m_hour;
+        auto const ms_in_hour = static_cast<int32_t>(m_epoch_ms - m_hour_start_ms);
+        result.minute      = ms_in_hour / 60000;
+        result.second      = (ms_in_hour / 1000) % 60;
+        result.millisecond = ms_in_hour % 1000;
+        return result;
+    }
+
+private:
+    std::unique_ptr<ClockSource> m_source;
+
+    int64_t m_epoch_ms{0};
+    int64_t m_steady_ns{0};
+
+    /// The local hour containing the snapshot, with minutes and seconds left to zero
+    LocalTime m_hour;
+    int64_t   m_hour_start_ms{0};
+    int64_t   m_hour_end_ms{0};
+
+    int64_t m_midnight_ms{0};
+    int64_t m_next_midnight_ms{0};
+
+    void updateHour()
+    {
+        std::tm const local_tm = toLocal(m_epoch_ms);
+        m_hour.year  = local_tm.tm_year + 1900;
+        m_hour.month = local_tm.tm_mon + 1;
+        m_hour.day   = local_tm.tm_mday;
+        m_hour.hour  = local_tm.tm_hour;
+        int64_t const ms_in_hour = (local_tm.tm_min * 60 + local_tm.tm_sec) * 1000 + floorMod(m_epoch_ms, 1000);
+        m_hour_start_ms = m_epoch_ms - ms_in_hour;
+        m_hour_end_ms   = m_hour_start_ms + 3600000;
+    }
+
+    void updateDay()
+    {
+        std::tm local_tm = toLocal(m_epoch_ms);
+        local_tm.tm_hour  = 0;
+        local_tm.tm_min   = 0;
+        local_tm.tm_sec   = 0;
+        local_tm.tm_isdst = -1;
+        std::tm next_tm = local_tm;
+        m_midnight_ms = static_cast<int64_t>(std::mktime(&local_tm)) * 1000;
+        // mktime normalizes the 32nd of a month and handles days that are not 24h long
+        ++next_tm.tm_mday;
+        m_next_midnight_ms = static_cast<int64_t>(std::mktime(&next_tm)) * 1000;
+    }
+
+    [[nodiscard]]
+    static std::tm toLocal(int64_t const epoch_ms)
+    {
+        auto const time = static_cast<std::time_t>((epoch_ms - floorMod(epoch_ms, 1000)) / 1000);
+        std::tm local_tm{};
+#ifdef _WIN32
+        localtime_s(&local_tm, &time);
+#else
+        localtime_r(&time, &local_tm);
+#endif
+        return local_tm;
+    }
+
+    [[nodiscard]]
+    static int64_t floorMod(int64_t const value, int64_t const divisor)
+    {
+        int64_t const result = value % divisor;
+        return (result < 0) ? result + divisor : result;
+    }
+};
+
+}
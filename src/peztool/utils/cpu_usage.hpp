@@ -0,0 +1,105 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+namespace pez
+{
+
+/// Measures the CPU time used by the process over periods of wall time
+struct CpuUsage
+{
+    CpuUsage()
+    {
+        restart();
+    }
+
+    void restart()
+    {
+        m_cpu_start  = getProcessCpuSeconds();
+        m_wall_start = std::chrono::steady_clock::now();
+        m_frame_count = 0;
+    }
+
+    void addFrame()
+    {
+        ++m_frame_count;
+    }
+
+    [[nodiscard]]
+    uint64_t getFrameCount() const
+    {
+        return m_frame_count;
+    }
+
+    /// Returns the wall time elapsed since the last restart
+    [[nodiscard]]
+    double getElapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_wall_start).count();
+    }
+
+    /// Returns the CPU usage since the last restart, 1 is one core fully used
+    [[nodiscard]]
+    double getUsage() const
+    {
+        double const elapsed = getElapsedSeconds();
+        return (elapsed > 0.0) ? (getProcessCpuSeconds() - m_cpu_start) / elapsed : 0.0;
+    }
+
+    /// Returns the rendered frames per second since the last restart
+    [[nodiscard]]
+    double getFrameRate() const
+    {
+        double const elapsed = getElapsedSeconds();
+        return (elapsed > 0.0) ? static_cast<double>(m_frame_count) / elapsed : 0.0;
+    }
+
+    /// Returns the user and system CPU time used by all the threads of the process
+    [[nodiscard]]
+    static double getProcessCpuSeconds()
+    {
+#ifdef _WIN32
+        FILETIME creation_time, exit_time, kernel_time, user_time;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+            return 0.0;
+        }
+        auto const toSeconds = [](FILETIME const& time) {
+            ULARGE_INTEGER value;
+            value.LowPart  = time.dwLowDateTime;
+            value.HighPart = time.dwHighDateTime;
+            // FILETIME is in 100ns units
+            return static_cast<double>(value.QuadPart) * 1.0e-7;
+        };
+        return toSeconds(kernel_time) + toSeconds(user_time);
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0.0;
+        }
+        auto const toSeconds = [](timeval const& time) {
+            return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_usec) * 1.0e-6;
+        };
+        return toSeconds(usage.ru_utime) + toSeconds(usage.ru_stime);
+#endif
+    }
+
+private:
+    double                                m_cpu_start{0.0};
+    std::chrono::steady_clock::time_point m_wall_start;
+    uint64_t                              m_frame_count{0};
+};
+
+}
@@ -3,7 +3,7 @@
 #include <cassert>
 #include <iostream>
 #include <vector>
-#include "peztool/core/index_vector.hpp"
+#include "./index_vector.hpp"
 
 
 template<typename TID>
@@ -1,14 +1,44 @@
 #pragma once
+#include <chrono>
 #include <map>
 #include <functional>
 #include <iostream>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 #include "SFML/Window/Window.hpp"
 
+#include "./latency_histogram.hpp"
+
 
 namespace pez
 {
 
+/// Gives each event type a small index, used to find its callbacks without testing them all
+struct EventTypeIndex
+{
+    template<typename TEvent>
+    [[nodiscard]]
+    static size_t get()
+    {
+        static size_t const s_index = s_count++;
+        return s_index;
+    }
+
+    /// Returns the index of the type held by @p event
+    [[nodiscard]]
+    static size_t get(sf::Event const& event)
+    {
+        return event.visit([](auto const& e) {
+            return EventTypeIndex::get<std::decay_t<decltype(e)>>();
+        });
+    }
+
+private:
+    static inline size_t s_count = 0;
+};
+
 /// The base object that will be used to check compatibility
 struct EventCallbackBase
 {
@@ -70,8 +100,11 @@ public:
     }
 };
 
-/**
+/** Routes the window events to the registered callbacks.
  *
+ * Callbacks are stored by event type so dispatching an event only calls the callbacks of its type.
+ * With coalescing enabled, consecutive mouse moves and wheel scrolls are merged and dispatched
+ * once, before the next event of another kind or at the end of processEvents.
  */
 class EventHandler
 {
@@ -112,19 +145,111 @@ public:
     template<typename TEvent>
     void addCallback(std::function<void(TEvent const&)> callback)
     {
-        m_event_callbacks.push_back(std::make_unique<EventCallback<TEvent>>(std::move(callback)));
+        size_t const type_index = EventTypeIndex::get<TEvent>();
+        if (type_index >= m_event_callbacks.size()) {
+            m_event_callbacks.resize(type_index + 1);
+        }
+        m_event_callbacks[type_index].push_back(std::make_unique<EventCallback<TEvent>>(std::move(callback)));
     }
 
-    void processEvents() const
+    void processEvents()
     {
         while (std::optional<sf::Event> const& event = m_window->pollEvent()) {
             if (event.has_value()) {
-                sf::Event const& valid_event{*event};
-                for (auto const& callback : m_event_callbacks) {
-                    callback->tryProcess(valid_event);
+                processEvent(*event);
+            }
+        }
+        flushPendingEvents();
+    }
+
+    /// Forwards an event received outside processEvents to the callbacks
+    void processEvent(sf::Event const& event)
+    {
+        ++m_received_count;
+        if (isInput(event)) {
+            m_input_times_ns.push_back(getNowNs());
+        }
+        if (m_coalescing) {
+            if (auto const* moved = event.getIf<sf::Event::MouseMoved>()) {
+                // Only the last position matters
+                if (m_pending_wheel) {
+                    flushPendingEvents();
                 }
+                m_pending_move = *moved;
+                return;
             }
+            if (auto const* scrolled = event.getIf<sf::Event::MouseWheelScrolled>()) {
+                // Deltas of the same wheel add up, the position is the last one
+                if (m_pending_move || (m_pending_wheel && m_pending_wheel->wheel != scrolled->wheel)) {
+                    flushPendingEvents();
+                }
+                float const delta = m_pending_wheel ? m_pending_wheel->delta : 0.0f;
+                m_pending_wheel = *scrolled;
+                m_pending_wheel->delta += delta;
+                return;
+            }
+            // Keep the order, merged events happened before this one
+            flushPendingEvents();
+        }
+        dispatch(event);
+    }
+
+    /// Dispatches the merged mouse events that are still waiting, if any
+    void flushPendingEvents()
+    {
+        if (m_pending_move) {
+            dispatch(*m_pending_move);
+            m_pending_move = std::nullopt;
+        }
+        if (m_pending_wheel) {
+            dispatch(*m_pending_wheel);
+            m_pending_wheel = std::nullopt;
+        }
+    }
+
+    /// Merges bursts of mouse moves and wheel scrolls, see the class description
+    void setCoalescing(bool const coalescing)
+    {
+        if (!coalescing) {
+            flushPendingEvents();
         }
+        m_coalescing = coalescing;
+    }
+
+    /// Records the latency of the inputs received since the last frame, to call once the frame is displayed
+    void onFramePresented()
+    {
+        int64_t const now_ns = getNowNs();
+        for (int64_t const time_ns : m_input_times_ns) {
+            m_input_latency.add(now_ns - time_ns);
+        }
+        m_input_times_ns.clear();
+    }
+
+    /// Returns the latencies between the reception of the inputs and the display of the frames showing them
+    [[nodiscard]]
+    LatencyHistogram const& getInputLatency() const
+    {
+        return m_input_latency;
+    }
+
+    void clearInputLatency()
+    {
+        m_input_latency.clear();
+    }
+
+    /// Returns the number of events received since the creation of the handler
+    [[nodiscard]]
+    uint64_t getReceivedCount() const
+    {
+        return m_received_count;
+    }
+
+    /// Returns the number of events dispatched to the callbacks, lower than received if events were merged
+    [[nodiscard]]
+    uint64_t getDispatchedCount() const
+    {
+        return m_dispatched_count;
     }
 
     void onKeyPressed(sf::Keyboard::Key const key_code, KeyPressedHandler::CallbackEvent callback)
@@ -160,7 +285,46 @@ private:
     MousePressedHandler m_mouse_pressed_handler;
     MouseReleasedHandler m_mouse_released_handler;
 
-    std::vector<std::unique_ptr<EventCallbackBase>> m_event_callbacks;
+    /// Callbacks by event type index
+    std::vector<std::vector<std::unique_ptr<EventCallbackBase>>> m_event_callbacks;
+
+    bool m_coalescing = false;
+    std::optional<sf::Event::MouseMoved>         m_pending_move;
+    std::optional<sf::Event::MouseWheelScrolled> m_pending_wheel;
+
+    uint64_t m_received_count = 0;
+    uint64_t m_dispatched_count = 0;
+
+    /// Reception times of the inputs not displayed yet
+    std::vector<int64_t> m_input_times_ns;
+    LatencyHistogram     m_input_latency;
+
+    [[nodiscard]]
+    static bool isInput(sf::Event const& event)
+    {
+        return event.is<sf::Event::KeyPressed>() || event.is<sf::Event::KeyReleased>() || event.is<sf::Event::TextEntered>()
+            || event.is<sf::Event::MouseMoved>() || event.is<sf::Event::MouseWheelScrolled>()
+            || event.is<sf::Event::MouseButtonPressed>() || event.is<sf::Event::MouseButtonReleased>();
+    }
+
+    [[nodiscard]]
+    static int64_t getNowNs()
+    {
+        auto const now = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    }
+
+    void dispatch(sf::Event const& event)
+    {
+        ++m_dispatched_count;
+        size_t const type_index = EventTypeIndex::get(event);
+        if (type_index >= m_event_callbacks.size()) {
+            return;
+        }
+        for (auto const& callback : m_event_callbacks[type_index]) {
+            callback->tryProcess(event);
+        }
+    }
 };
 
 }
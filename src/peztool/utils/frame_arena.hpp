@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../core/static_interface.hpp"
+
+
+namespace pez
+{
+
+/** Bump allocator for the temporaries of a frame, reset at the end of SceneBase::tick.
+ *
+ * Allocating moves a pointer, freeing does nothing. When a frame needs more than the current
+ * block, extra blocks are allocated and merged into a single larger block at the next reset, so
+ * after a few frames the arena stops allocating. Only used from the thread that created it, the
+ * main thread, systems running on the thread pool cannot use it.
+ */
+struct FrameArena
+{
+    static size_t constexpr default_capacity = 256 * 1024;
+
+    explicit
+    FrameArena(size_t const capacity = default_capacity)
+    {
+        addBlock(capacity);
+    }
+
+    FrameArena(FrameArena const&) = delete;
+    FrameArena& operator=(FrameArena const&) = delete;
+
+    [[nodiscard]]
+    void* allocate(size_t const size, size_t const alignment)
+    {
+        assert(std::this_thread::get_id() == m_owner_thread);
+        Block& block = m_blocks.back();
+        auto const address = reinterpret_cast<uintptr_t>(block.data.get());
+        size_t const start = ((address + block.used + alignment - 1) & ~(alignment - 1)) - address;
+        if (start + size > block.capacity) {
+            // Big enough for the allocation and for the usual growth of a frame
+            addBlock(std::max(2 * block.capacity, size + alignment));
+            ++m_growth_count;
+            return allocate(size, alignment);
+        }
+        block.used = start + size;
+        m_used    += size;
+        return block.data.get() + start;
+    }
+
+    /// Releases all the allocations of the frame, the memory is kept for the next one
+    void reset()
+    {
+        assert(std::this_thread::get_id() == m_owner_thread);
+        m_peak_used = std::max(m_peak_used, m_used);
+        if (m_blocks.size() > 1) {
+            size_t capacity = 0;
+            for (Block const& block : m_blocks) {
+                capacity += block.capacity;
+            }
+            m_blocks.clear();
+            addBlock(capacity);
+        }
+        m_blocks.back().used = 0;
+        m_used = 0;
+    }
+
+    /// Returns the number of bytes allocated since the last reset
+    [[nodiscard]]
+    size_t getUsed() const
+    {
+        return m_used;
+    }
+
+    /// Returns the highest number of bytes used by a frame
+    [[nodiscard]]
+    size_t getPeakUsed() const
+    {
+        return m_peak_used;
+    }
+
+    [[nodiscard]]
+    size_t getCapacity() const
+    {
+        size_t capacity = 0;
+        for (Block const& block : m_blocks) {
+            capacity += block.capacity;
+        }
+        return capacity;
+    }
+
+    /// Returns the number of times the arena had to allocate a new block
+    [[nodiscard]]
+    uint64_t getGrowthCount() const
+    {
+        return m_growth_count;
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t                       capacity = 0;
+        size_t                       used     = 0;
+    };
+
+    std::thread::id    m_owner_thread = std::this_thread::get_id();
+    std::vector<Block> m_blocks;
+    size_t             m_used         = 0;
+    size_t             m_peak_used    = 0;
+    uint64_t           m_growth_count = 0;
+
+    void addBlock(size_t const capacity)
+    {
+        m_blocks.push_back({std::make_unique<std::byte[]>(capacity), capacity, 0});
+    }
+};
+
+/// Standard allocator using the FrameArena singleton, containers using it must not outlive the frame
+template<typename T>
+struct FrameAllocator
+{
+    using value_type = T;
+
+    FrameAllocator() noexcept
+        : arena{&Singleton<FrameArena>::get()}
+    {}
+
+    template<typename U>
+    FrameAllocator(FrameAllocator<U> const& other) noexcept
+        : arena{other.arena}
+    {}
+
+    [[nodiscard]]
+    T* allocate(size_t const count)
+    {
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) noexcept
+    {
+        // Released all at once by FrameArena::reset
+    }
+
+    template<typename U>
+    bool operator==(FrameAllocator<U> const& other) const noexcept
+    {
+        return arena == other.arena;
+    }
+
+    FrameArena* arena;
+};
+
+/// A vector of temporaries allocated in the frame arena
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+/// A string buffer allocated in the frame arena
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+}
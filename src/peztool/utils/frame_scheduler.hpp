@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+
+namespace pez
+{
+
+/** Decides when the next frame has to be rendered.
+ *
+ * A frame is due when it has been explicitly requested, when an animation is running, or when
+ * a requested wake up time is reached. Times are monotonic nanoseconds.
+ */
+struct FrameScheduler
+{
+    static int64_t constexpr no_deadline = std::numeric_limits<int64_t>::max();
+
+    /// Renders one frame as soon as possible
+    void requestFrame()
+    {
+        m_frame_requested = true;
+    }
+
+    /// Renders one frame at @p time_ns
+    void requestFrameAt(int64_t const time_ns)
+    {
+        m_wakeup_ns = std::min(m_wakeup_ns, time_ns);
+    }
+
+    /// Renders frames continuously until @p time_ns
+    void requestFramesUntil(int64_t const time_ns)
+    {
+        m_animation_end_ns = std::max(m_animation_end_ns, time_ns);
+    }
+
+    /// Renders frames continuously until the tick @p tick is reached
+    void requestFramesUntilTick(uint64_t const tick)
+    {
+        m_animation_end_tick = std::max(m_animation_end_tick, tick);
+    }
+
+    /// Returns how long to wait before the next frame, 0 if it is due now
+    [[nodiscard]]
+    int64_t getWaitNs(int64_t const now_ns, uint64_t const current_tick) const
+    {
+        if (m_frame_requested || now_ns < m_animation_end_ns || current_tick < m_animation_end_tick) {
+            return 0;
+        }
+        if (m_wakeup_ns == no_deadline) {
+            return no_deadline;
+        }
+        return std::max(int64_t{0}, m_wakeup_ns - now_ns);
+    }
+
+    /// Consumes the requests fulfilled by the frame starting at @p now_ns
+    void onFrame(int64_t const now_ns)
+    {
+        m_frame_requested = false;
+        if (m_wakeup_ns <= now_ns) {
+            m_wakeup_ns = no_deadline;
+        }
+    }
+
+private:
+    bool     m_frame_requested{true};
+    int64_t  m_wakeup_ns{no_deadline};
+    int64_t  m_animation_end_ns{0};
+    uint64_t m_animation_end_tick{0};
+};
+
+}
@@ -29,6 +29,13 @@ public:
         m_speed = speed;
     }
 
+    /// Returns the time needed to complete an interpolation
+    [[nodiscard]]
+    float getDuration() const
+    {
+        return 1.0f / m_speed;
+    }
+
     /// Sets interpolation function and speed
     virtual void setInterpolation(InterpolationFunction const function, float const speed)
     {
@@ -59,6 +59,8 @@ public:
         m_target_value = value;
         m_delta        = m_target_value - m_start_value;
         reset();
+        // Keep rendering frames until the interpolation is done
+        App::requestAnimation(getDuration(), m_use_realtime);
     }
 
     /// Instantly sets the current value to the provided one
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+
+namespace pez
+{
+
+/** Counts durations in fixed width buckets, durations above the last bucket are counted in it.
+ *
+ * Used to follow the input to display latency, percentiles are precise to one bucket width.
+ */
+struct LatencyHistogram
+{
+    /// Width of a bucket in microseconds
+    static int64_t constexpr bucket_width_us = 500;
+    static size_t constexpr bucket_count = 200;
+
+    void add(int64_t const latency_ns)
+    {
+        int64_t const latency_us = std::max(latency_ns / 1000, int64_t{0});
+        size_t const bucket = std::min(static_cast<size_t>(latency_us / bucket_width_us), bucket_count - 1);
+        ++m_buckets[bucket];
+        ++m_count;
+        m_total_us += latency_us;
+        m_max_us = std::max(m_max_us, latency_us);
+    }
+
+    void clear()
+    {
+        m_buckets.fill(0);
+        m_count    = 0;
+        m_total_us = 0;
+        m_max_us   = 0;
+    }
+
+    [[nodiscard]]
+    uint64_t getCount() const
+    {
+        return m_count;
+    }
+
+    [[nodiscard]]
+    uint64_t getBucket(size_t const bucket) const
+    {
+        return m_buckets[bucket];
+    }
+
+    /// Returns the mean latency in milliseconds
+    [[nodiscard]]
+    double getMeanMs() const
+    {
+        if (m_count == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(m_total_us) / static_cast<double>(m_count) * 0.001;
+    }
+
+    [[nodiscard]]
+    double getMaxMs() const
+    {
+        return static_cast<double>(m_max_us) * 0.001;
+    }
+
+    /// Returns the upper bound in milliseconds of the bucket holding the @p ratio percentile, @p ratio is in [0, 1]
+    [[nodiscard]]
+    double getPercentileMs(double const ratio) const
+    {
+        if (m_count == 0) {
+            return 0.0;
+        }
+        auto const target = static_cast<uint64_t>(ratio * static_cast<double>(m_count - 1)) + 1;
+        uint64_t sum = 0;
+        for (size_t i{0}; i < bucket_count; ++i) {
+            sum += m_buckets[i];
+            if (sum >= target) {
+                return static_cast<double>((i + 1) * bucket_width_us) * 0.001;
+            }
+        }
+        return getMaxMs();
+    }
+
+private:
+    std::array<uint64_t, bucket_count> m_buckets{};
+    uint64_t m_count    = 0;
+    int64_t  m_total_us = 0;
+    int64_t  m_max_us   = 0;
+};
+
+}
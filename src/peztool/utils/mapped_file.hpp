@@ -0,0 +1,161 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace pez
+{
+
+/// Read only memory mapping of a whole file
+struct MappedFile
+{
+    MappedFile() = default;
+
+    explicit
+    MappedFile(std::filesystem::path const& filepath)
+    {
+        open(filepath);
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            std::swap(m_data, other.m_data);
+            std::swap(m_size, other.m_size);
+#ifdef _WIN32
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#endif
+        }
+        return *this;
+    }
+
+    /// Maps the file, returns false if it cannot be opened or is empty
+    bool open(std::filesystem::path const& filepath)
+    {
+        close();
+#ifdef _WIN32
+        m_file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart == 0) {
+            close();
+            return false;
+        }
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping) {
+            close();
+            return false;
+        }
+        void* const data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            close();
+            return false;
+        }
+        m_data = static_cast<uint8_t const*>(data);
+        m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+        int const fd = ::open(filepath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        auto const size = static_cast<size_t>(file_stat.st_size);
+        void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping stays valid once the descriptor is closed
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        m_data = static_cast<uint8_t const*>(data);
+        m_size = size;
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (m_data) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_data) {
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    [[nodiscard]]
+    bool isValid() const
+    {
+        return m_data != nullptr;
+    }
+
+    [[nodiscard]]
+    uint8_t const* data() const
+    {
+        return m_data;
+    }
+
+    [[nodiscard]]
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    uint8_t const* m_data = nullptr;
+    size_t         m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file    = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+namespace pez
+{
+
+/** Bounded lock-free queue with any number of producers and a single consumer.
+ *
+ * The ring is allocated once, pushing and popping do not allocate. Each slot carries a sequence
+ * number telling whether it is free for the next push or holds a value for the next pop, producers
+ * only compete on the write index.
+ */
+template<typename T>
+struct MPSCQueue
+{
+    /// @p capacity is rounded up to a power of two
+    explicit
+    MPSCQueue(size_t const capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        m_mask  = size - 1;
+        m_slots = std::make_unique<Slot[]>(size);
+        for (size_t i{0}; i < size; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Can be called from any thread, returns false if the queue is full
+    template<typename TValue>
+    bool tryPush(TValue&& value)
+    {
+        size_t position = m_write.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[position & m_mask];
+            size_t const sequence = slot.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                // The slot is free, claim it
+                if (m_write.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.value = std::forward<TValue>(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The consumer did not free this slot yet
+                return false;
+            } else {
+                position = m_write.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Only called by the consumer thread, returns false if the queue is empty
+    bool tryPop(T& value)
+    {
+        Slot& slot = m_slots[m_read & m_mask];
+        size_t const sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != m_read + 1) {
+            return false;
+        }
+        value = std::move(slot.value);
+        // Frees the slot for the push one lap later
+        slot.sequence.store(m_read + m_mask + 1, std::memory_order_release);
+        ++m_read;
+        return true;
+    }
+
+    [[nodiscard]]
+    size_t getCapacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence{0};
+        T                   value{};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t                  m_mask = 0;
+    /// Producers and consumer indexes on their own cache lines
+    alignas(64) std::atomic<size_t> m_write{0};
+    alignas(64) size_t              m_read{0};
+};
+
+}
@@ -1,7 +1,9 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 
 #include "./shader.hpp"
+#include "../draw_calls.hpp"
 
 struct Blur
 {
@@ -13,6 +15,10 @@ struct Blur
     sf::Vector2i original_size;
     sf::Vector2i current_size;
     float current_scale{1.0f};
+    /// The kernel radius, in pixels of the texture of the current pass
+    float radius{4.5f};
+    /// The area that has to be correct in the result, in pixels of the original texture
+    sf::FloatRect region;
 
     explicit
     Blur(sf::Vector2u const render_size)
@@ -23,6 +29,14 @@ struct Blur
         createTexture(textures[1], render_size);
 
         kernel.setRenderSize(Vec2f{render_size});
+        kernel.setRadius(radius);
+        region = {{}, Vec2f{render_size}};
+    }
+
+    void setRadius(float const radius_)
+    {
+        radius = radius_;
+        kernel.setRadius(radius);
     }
 
     void capture(sf::Texture const& texture)
@@ -30,9 +44,11 @@ struct Blur
         current_size = original_size;
         current_scale = 1.0f;
         read_texture = 0;
+        setScissor(textures[read_texture], 1.0f);
         sf::Sprite const context_sprite{texture};
         textures[read_texture].draw(context_sprite);
         textures[read_texture].display();
+        pez::DrawCalls::add();
     }
 
     void scaledBlur(float const scale)
@@ -41,6 +57,7 @@ struct Blur
         kernel.setGlobalScale(current_scale);
         kernel.setTexture(source_texture);
         kernel.setScale(scale);
+        setScissor(textures[!read_texture], current_scale * scale);
         swapAndDraw(getSourceSprite(Vec2f{scale, scale}), kernel);
         current_scale *= scale;
         current_size = Vec2i{Vec2f{current_size} * scale};
@@ -50,14 +67,28 @@ struct Blur
     {
         Vec2f const ratio = Vec2f{original_size}.componentWiseDiv(Vec2f{current_size});
         Vec2f const rescale = {std::max(ratio.x, 1.0f), std::max(ratio.y, 1.0f)};
+        setScissor(textures[!read_texture], 1.0f);
         swapAndDraw(getSourceSprite(rescale));
     }
 
     [[nodiscard]]
     sf::Texture const& apply(sf::Texture const& texture)
     {
+        return apply(texture, {{}, Vec2f{original_size}});
+    }
+
+    /** Blurs @p texture, only the pixels of @p region_ are guaranteed to be correct.
+     *
+     * The passes only render the region extended by the distance the kernel reaches over all
+     * the passes, the rest of the result is left unchanged.
+     */
+    [[nodiscard]]
+    sf::Texture const& apply(sf::Texture const& texture, sf::FloatRect const region_)
+    {
+        // One more texel per pass covers the bilinear filtering of the scaled sprites
+        float const reach = (radius + 1.0f) * getReachFactor();
+        region = {region_.position - Vec2f{reach, reach}, region_.size + 2.0f * Vec2f{reach, reach}};
         capture(texture);
-        size_t constexpr pass_count = 3;
         for (size_t i = 0; i < pass_count; ++i) {
             scaledBlur(0.5f);
         }
@@ -74,11 +105,58 @@ struct Blur
         return apply(context.getTexture());
     }
 
+    [[nodiscard]]
+    sf::Texture const& apply(pez::RenderContext& context, sf::FloatRect const region_)
+    {
+        return apply(context.getTexture(), region_);
+    }
+
+    [[nodiscard]]
+    sf::Texture const& getTexture() const
+    {
+        return textures[read_texture].getTexture();
+    }
+
 private:
+    static size_t constexpr pass_count = 3;
+
+    /// Returns how far one texel of each pass reaches in the original texture, summed over all the passes
+    [[nodiscard]]
+    static float getReachFactor()
+    {
+        // Each pass samples one radius away in the texture it reads, which is scaled down
+        float factor = 0.0f;
+        float scale = 1.0f;
+        for (size_t i = 0; i < pass_count; ++i) {
+            factor += 1.0f / scale;
+            scale *= 0.5f;
+        }
+        for (size_t i = 0; i < pass_count; ++i) {
+            factor += 1.0f / scale;
+            scale *= 2.0f;
+        }
+        return factor;
+    }
+
+    /// Restricts the rendering in @p texture to the region, @p scale being the scale of its content
+    void setScissor(sf::RenderTexture& texture, float const scale) const
+    {
+        // Scaled content is anchored to the bottom left corner
+        Vec2f const size{original_size};
+        Vec2f const top_left{region.position.x * scale, size.y - (size.y - region.position.y) * scale};
+        Vec2f const bottom_right = top_left + region.size * scale;
+        Vec2f const clamped_top_left{std::clamp(top_left.x, 0.0f, size.x), std::clamp(top_left.y, 0.0f, size.y)};
+        Vec2f const clamped_bottom_right{std::clamp(bottom_right.x, 0.0f, size.x), std::clamp(bottom_right.y, 0.0f, size.y)};
+        sf::View view = texture.getDefaultView();
+        view.setScissor({clamped_top_left.componentWiseDiv(size), (clamped_bottom_right - clamped_top_left).componentWiseDiv(size)});
+        texture.setView(view);
+    }
+
     void swapAndDraw(sf::Sprite const& sprite, sf::Shader const* const shader = nullptr)
     {
         textures[!read_texture].draw(sprite, shader);
         textures[!read_texture].display();
+        pez::DrawCalls::add();
         read_texture = !read_texture;
     }
 
@@ -3,8 +3,8 @@
 #include "../../vec.hpp"
 #include "./shader.hpp"
 #include "./utils.hpp"
-#include "../quad_vertex_array.hpp"
-#include "./shadow_shader.hpp"
+#include "./shadow_atlas.hpp"
+#include "../draw_calls.hpp"
 
 
 namespace pez
@@ -13,7 +13,8 @@ namespace pez
 struct Card : public sf::Drawable, public sf::Transformable
 {
     sf::VertexArray va;
-    QuadVertexArray va_shadow;
+    /// Nine-slice shadow, generated when drawn since the shadow attributes can be changed directly
+    mutable sf::VertexArray va_shadow;
 
     Vec2f     size;
     float     corner_radius = 0.0f;
@@ -28,12 +29,12 @@ struct Card : public sf::Drawable, public sf::Transformable
 
     Card()
         : va{sf::PrimitiveType::TriangleFan}
-        , va_shadow{1}
+        , va_shadow{sf::PrimitiveType::Triangles}
     {}
 
     Card(Vec2f const size_, float const corner_radius_, sf::Color const color_)
         : va{sf::PrimitiveType::TriangleFan}
-        , va_shadow{1}
+        , va_shadow{sf::PrimitiveType::Triangles}
         , size{size_}
         , corner_radius{corner_radius_}
         , color{color_}
@@ -68,8 +69,13 @@ struct Card : public sf::Drawable, public sf::Transformable
         if (skip) {
             return;
         }
-        generateGeometry(va);
-        generateGeometryShadow(va_shadow);
+        // Cards are often updated with an unchanged shape, the fill geometry is then still valid
+        if (size != m_generated_size || corner_radius != m_generated_radius || quality != m_generated_quality) {
+            generateGeometry(va);
+            m_generated_size    = size;
+            m_generated_radius  = corner_radius;
+            m_generated_quality = quality;
+        }
         setColor(color);
     }
 
@@ -83,17 +89,13 @@ struct Card : public sf::Drawable, public sf::Transformable
     {
         states.transform *= getTransform();
         if (shadow_size > 0.0f) {
+            updateShadowGeometry();
             sf::RenderStates states_shadow = states;
-            states_shadow.texture = nullptr;
-            Vec2f const quad_size = getShadowQuadSize();
+            states_shadow.texture = &ShadowAtlas::get().getTexture();
+            states_shadow.shader  = nullptr;
             states_shadow.transform.translate(shadow_offset);
-            states_shadow.transform.translate(size * 0.5f);
-            states_shadow.shader = ShadowShader::get(
-                quad_size.x / quad_size.y,
-                corner_radius / quad_size.y,
-                quad_size.componentWiseDiv(size),
-                shadow_color);
             target.draw(va_shadow, states_shadow);
+            DrawCalls::add();
         }
 
         if (blur_background) {
@@ -102,6 +104,7 @@ struct Card : public sf::Drawable, public sf::Transformable
             states.texture = m_texture;
         }
         target.draw(va, states);
+        DrawCalls::add();
     }
 
     void setWidth(float width, bool skip_geometry_update = false)
@@ -138,20 +141,13 @@ struct Card : public sf::Drawable, public sf::Transformable
         generator.generateVertex(&vertex_array);
     }
 
-    void generateGeometryShadow(QuadVertexArray& vertex_array)
+    /// Generates the shadow without its offset, in atlas texture coordinates
+    void generateGeometryShadow(sf::VertexArray& vertex_array) const
     {
-        Vec2f const quad_size = getShadowQuadSize();
-        vertex_array.createAlignedRectangle(0, quad_size, {0.0f, 0.0f});
-        vertex_array.setVertex0Color(0, {0, 0, 0});
-        vertex_array.setVertex1Color(0, {255, 0, 0});
-        vertex_array.setVertex2Color(0, {255, 255, 0});
-        vertex_array.setVertex3Color(0, {0, 255, 0});
-    }
-
-    [[nodiscard]]
-    Vec2f getShadowQuadSize() const
-    {
-        return size + 2.0f * Vec2f{shadow_size, shadow_size};
+        vertex_array.clear();
+        ShadowAtlas::get().generateShadow(size, corner_radius, shadow_size, {}, shadow_color, [&vertex_array](sf::Vertex const& vertex) {
+            vertex_array.append(vertex);
+        });
     }
 
     void setTexture(sf::Texture const* texture_, float texture_scale = 1.0f)
@@ -168,7 +164,36 @@ struct Card : public sf::Drawable, public sf::Transformable
         }
     }
 
+    [[nodiscard]]
+    sf::Texture const* getTexture() const
+    {
+        return m_texture;
+    }
+
 private:
     sf::Texture const* m_texture = nullptr;
+
+    /// The shape of the current fill geometry
+    Vec2f    m_generated_size    = {-1.0f, -1.0f};
+    float    m_generated_radius  = -1.0f;
+    uint32_t m_generated_quality = 0;
+
+    /// The attributes of the current shadow geometry
+    mutable Vec2f     m_shadow_size   = {-1.0f, -1.0f};
+    mutable float     m_shadow_radius = -1.0f;
+    mutable float     m_shadow_extent = -1.0f;
+    mutable sf::Color m_shadow_color  = sf::Color::Transparent;
+
+    void updateShadowGeometry() const
+    {
+        if (size == m_shadow_size && corner_radius == m_shadow_radius && shadow_size == m_shadow_extent && shadow_color == m_shadow_color) {
+            return;
+        }
+        generateGeometryShadow(va_shadow);
+        m_shadow_size   = size;
+        m_shadow_radius = corner_radius;
+        m_shadow_extent = shadow_size;
+        m_shadow_color  = shadow_color;
+    }
 };
 }
@@ -0,0 +1,141 @@
+#pragma once
+#include <cassert>
+#include <vector>
+
+#include "./card.hpp"
+#include "./card_outlined.hpp"
+#include "../draw_calls.hpp"
+
+
+namespace pez
+{
+
+/** Packs the shadows and the fills of several cards in one vertex stream each.
+ *
+ * A flush issues one draw for all the shadows and one draw for all the fills. The shadows are
+ * drawn before the fills, so the cards of a batch should not overlap each other, like the slots
+ * of a bar. Only plain cards can be batched, textured and blurred cards need their own states.
+ */
+struct CardBatch
+{
+    /// Returns true if @p card can be added to a batch
+    [[nodiscard]]
+    static bool isBatchable(Card const& card)
+    {
+        return !card.blur_background && !card.getTexture();
+    }
+
+    [[nodiscard]]
+    static bool isBatchable(CardOutlined const& card)
+    {
+        return isBatchable(card.background) && !card.outline.blur_background;
+    }
+
+    /// Adds @p card, @p transform is applied on top of the card's own transform
+    void add(Card const& card, sf::Transform const& transform = sf::Transform::Identity)
+    {
+        assert(isBatchable(card));
+        sf::Transform const card_transform = transform * card.getTransform();
+        if (card.shadow_size > 0.0f) {
+            addShadow(card, card_transform);
+        }
+        addFill(card, card_transform);
+        ++m_card_count;
+    }
+
+    /// Adds the background and the outline of @p card, the outline has no shadow
+    void add(CardOutlined const& card, sf::Transform const& transform = sf::Transform::Identity)
+    {
+        assert(isBatchable(card));
+        sf::Transform const card_transform = transform * card.getTransform();
+        add(card.background, card_transform);
+        addOutline(card.outline, card_transform * card.outline.getTransform());
+    }
+
+    /// Draws all the cards added since the last flush
+    void flush(sf::RenderTarget& target, sf::RenderStates states = sf::RenderStates::Default)
+    {
+        if (!m_shadows.empty()) {
+            sf::RenderStates shadow_states = states;
+            shadow_states.texture = &ShadowAtlas::get().getTexture();
+            shadow_states.shader  = nullptr;
+            target.draw(m_shadows.data(), m_shadows.size(), sf::PrimitiveType::Triangles, shadow_states);
+            DrawCalls::add();
+        }
+        if (!m_fills.empty()) {
+            states.texture = nullptr;
+            states.shader  = nullptr;
+            target.draw(m_fills.data(), m_fills.size(), sf::PrimitiveType::Triangles, states);
+            DrawCalls::add();
+        }
+        clear();
+    }
+
+    /// Drops the cards added since the last flush
+    void clear()
+    {
+        m_shadows.clear();
+        m_fills.clear();
+        m_card_count = 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const
+    {
+        return m_card_count == 0;
+    }
+
+    [[nodiscard]]
+    size_t getCardCount() const
+    {
+        return m_card_count;
+    }
+
+private:
+    std::vector<sf::Vertex> m_shadows;
+    std::vector<sf::Vertex> m_fills;
+    size_t                  m_card_count = 0;
+
+    /// Appends the nine-slice shadow
+    void addShadow(Card const& card, sf::Transform const& transform)
+    {
+        ShadowAtlas::get().generateShadow(card.size, card.corner_radius, card.shadow_size, card.shadow_offset, card.shadow_color, [&](sf::Vertex vertex) {
+            vertex.position = transform.transformPoint(vertex.position);
+            m_shadows.push_back(vertex);
+        });
+    }
+
+    /// Appends the fill triangle fan as a triangle list
+    void addFill(Card const& card, sf::Transform const& transform)
+    {
+        size_t const vertex_count = card.va.getVertexCount();
+        if (vertex_count < 3) {
+            return;
+        }
+        sf::Vertex center = card.va[0];
+        center.position = transform.transformPoint(center.position);
+        sf::Vertex previous = card.va[1];
+        previous.position = transform.transformPoint(previous.position);
+        for (size_t i{2}; i < vertex_count; ++i) {
+            sf::Vertex current = card.va[i];
+            current.position = transform.transformPoint(current.position);
+            m_fills.insert(m_fills.end(), {center, previous, current});
+            previous = current;
+        }
+    }
+
+    /// Appends the outline triangle strip as a triangle list
+    void addOutline(CardEmpty const& outline, sf::Transform const& transform)
+    {
+        size_t const vertex_count = outline.va.getVertexCount();
+        for (size_t i{2}; i < vertex_count; ++i) {
+            for (size_t const k : {i - 2, i - 1, i}) {
+                sf::Vertex vertex = outline.va[k];
+                vertex.position = transform.transformPoint(vertex.position);
+                m_fills.push_back(vertex);
+            }
+        }
+    }
+};
+
+}
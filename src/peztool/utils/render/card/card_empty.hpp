@@ -3,6 +3,7 @@
 #include "SFML/Graphics.hpp"
 #include "../../../utils/vec.hpp"
 #include "utils.hpp"
+#include "../draw_calls.hpp"
 
 namespace pez
 {
@@ -85,6 +86,7 @@ struct CardEmpty final : public sf::Drawable, public sf::Transformable
             states.texture = nullptr;
         }
         target.draw(va, states);
+        DrawCalls::add();
     }
 
     void setWidth(float width, bool skip_geometry_update = false)
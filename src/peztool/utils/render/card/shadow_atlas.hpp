@@ -0,0 +1,208 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+#include "../../vec.hpp"
+
+
+namespace pez
+{
+
+/** Stores rasterized card shadow corners in a single texture.
+ *
+ * A card shadow is a rounded rectangle distance field: outside of its core rectangle the opacity
+ * only depends on the distance to the core, so one corner is enough to draw the whole shadow as
+ * nine slices. Corners are rasterized once per (radius, shadow size, carve) in white and tinted
+ * by the vertex color, so all the shadows share one texture and can be drawn in one call.
+ */
+struct ShadowAtlas
+{
+    static ShadowAtlas& get()
+    {
+        static ShadowAtlas s_instance;
+        return s_instance;
+    }
+
+    [[nodiscard]]
+    sf::Texture const& getTexture() const
+    {
+        return m_texture;
+    }
+
+    /** Generates the triangles of the shadow of a card of @p size.
+     *
+     * @param size          The size of the card
+     * @param radius        The corner radius of the card
+     * @param shadow_size   How far the shadow extends out of the card
+     * @param offset        The shadow offset
+     * @param color         The shadow color
+     * @param add_vertex    Called with each vertex, in card space
+     */
+    template<typename TCallback>
+    void generateShadow(Vec2f const size, float const radius, float const shadow_size, Vec2f const offset, sf::Color const color, TCallback&& add_vertex)
+    {
+        Vec2f const half_size = size * 0.5f;
+        Vec2f const inner     = half_size - Vec2f{radius, radius};
+        float const carve     = 0.4f * shadow_size;
+        float const from_size = std::min(std::min(inner.x, inner.y), carve);
+        Vec2f const core      = inner - Vec2f{from_size, from_size};
+        Corner const corner   = getCorner(radius, shadow_size, from_size);
+
+        // Cell boundaries along each axis, the distance to the core is linear in each cell
+        Vec2f const half_quad = half_size + Vec2f{shadow_size, shadow_size};
+        auto const getSplits = [](float const half, float const core_half, std::array<float, 4>& splits) {
+            size_t count = 0;
+            splits[count++] = -half;
+            if (core_half > 0.0f) {
+                splits[count++] = -core_half;
+                splits[count++] = core_half;
+            } else {
+                splits[count++] = 0.0f;
+            }
+            splits[count++] = half;
+            return count;
+        };
+        std::array<float, 4> xs{};
+        std::array<float, 4> ys{};
+        size_t const x_count = getSplits(half_quad.x, core.x, xs);
+        size_t const y_count = getSplits(half_quad.y, core.y, ys);
+
+        Vec2f const center = half_size + offset;
+        auto const getVertex = [&](float const x, float const y) {
+            Vec2f const distance{
+                std::clamp(std::abs(x) - core.x, 0.0f, corner.max_distance),
+                std::clamp(std::abs(y) - core.y, 0.0f, corner.max_distance)
+            };
+            // Texel k holds the opacity at distance k
+            return sf::Vertex{center + Vec2f{x, y}, color, corner.origin + distance + Vec2f{0.5f, 0.5f}};
+        };
+        for (size_t j{0}; j + 1 < y_count; ++j) {
+            for (size_t i{0}; i + 1 < x_count; ++i) {
+                sf::Vertex const top_left     = getVertex(xs[i], ys[j]);
+                sf::Vertex const top_right    = getVertex(xs[i + 1], ys[j]);
+                sf::Vertex const bottom_right = getVertex(xs[i + 1], ys[j + 1]);
+                sf::Vertex const bottom_left  = getVertex(xs[i], ys[j + 1]);
+                add_vertex(top_left);
+                add_vertex(top_right);
+                add_vertex(bottom_right);
+                add_vertex(bottom_right);
+                add_vertex(bottom_left);
+                add_vertex(top_left);
+            }
+        }
+    }
+
+    /// Returns the number of rasterized corners
+    [[nodiscard]]
+    size_t getCornerCount() const
+    {
+        return m_corners.size();
+    }
+
+private:
+    static uint32_t constexpr atlas_size = 1024;
+    /// Corner parameters are rounded to this step to bound the number of corners
+    static float constexpr precision = 0.25f;
+    /// Empty space around corners so that bilinear filtering does not bleed between them
+    static uint32_t constexpr spacing = 2;
+
+    using Key = std::tuple<int32_t, int32_t, int32_t>;
+
+    struct Corner
+    {
+        Vec2f origin;
+        /// The largest distance stored, the shadow quad never goes further
+        float max_distance = 0.0f;
+    };
+
+    sf::Texture m_texture;
+    std::map<Key, Corner> m_corners;
+
+    // Shelf packing
+    uint32_t m_shelf_x = 0;
+    uint32_t m_shelf_y = 0;
+    uint32_t m_shelf_height = 0;
+
+    ShadowAtlas()
+    {
+        if (!m_texture.resize({atlas_size, atlas_size})) {
+            std::cout << "ERROR: Failed to create shadow atlas." << std::endl;
+        }
+        m_texture.setSmooth(true);
+        // Texel (0, 0) is kept transparent, it is used when the atlas is full
+        std::vector<uint8_t> const empty(4 * atlas_size * atlas_size, 0);
+        m_texture.update(empty.data());
+        m_shelf_x = 1 + spacing;
+    }
+
+    /// Returns the corner in the atlas, rasterizes it if needed
+    Corner getCorner(float const radius, float const shadow_size, float const from_size)
+    {
+        auto const quantize = [](float const value) {
+            return static_cast<int32_t>(std::round(value / precision));
+        };
+        Key const key{quantize(radius), quantize(shadow_size), quantize(from_size)};
+        if (auto const it = m_corners.find(key); it != m_corners.end()) {
+            return it->second;
+        }
+        Corner const corner = rasterize(
+            static_cast<float>(std::get<0>(key)) * precision,
+            static_cast<float>(std::get<1>(key)) * precision,
+            static_cast<float>(std::get<2>(key)) * precision
+        );
+        m_corners[key] = corner;
+        return corner;
+    }
+
+    /// Same opacity function as the former shadow fragment shader, as a function of the distance to the core
+    Corner rasterize(float const radius, float const shadow_size, float const from_size)
+    {
+        float const carve     = 0.4f * shadow_size;
+        float const remaining = carve - from_size;
+        float const falloff_from = radius - remaining;
+        float const falloff_to   = radius + shadow_size + from_size;
+        // The shadow ends at the card's shadow quad, one more texel for the edge
+        auto const extent = static_cast<uint32_t>(std::ceil(shadow_size + radius + from_size)) + 1;
+
+        if (m_shelf_x + extent > atlas_size) {
+            m_shelf_x = 0;
+            m_shelf_y += m_shelf_height + spacing;
+            m_shelf_height = 0;
+        }
+        if (m_shelf_y + extent > atlas_size) {
+            std::cout << "ERROR: Shadow atlas is full." << std::endl;
+            return {};
+        }
+
+        std::vector<uint8_t> pixels(4 * extent * extent);
+        for (uint32_t y{0}; y < extent; ++y) {
+            for (uint32_t x{0}; x < extent; ++x) {
+                float const distance = std::sqrt(static_cast<float>(x * x + y * y));
+                float const t = std::clamp((distance - falloff_from) / std::max(falloff_to - falloff_from, 0.001f), 0.0f, 1.0f);
+                float const alpha = 1.0f - t * t * (3.0f - 2.0f * t);
+                size_t const idx = 4 * (y * extent + x);
+                pixels[idx + 0] = 255;
+                pixels[idx + 1] = 255;
+                pixels[idx + 2] = 255;
+                pixels[idx + 3] = static_cast<uint8_t>(std::round(0.5f * alpha * alpha * alpha * 255.0f));
+            }
+        }
+        m_texture.update(pixels.data(), {extent, extent}, {m_shelf_x, m_shelf_y});
+
+        Corner const corner{
+            {static_cast<float>(m_shelf_x), static_cast<float>(m_shelf_y)},
+            static_cast<float>(extent - 1)
+        };
+        m_shelf_x += extent + spacing;
+        m_shelf_height = std::max(m_shelf_height, extent);
+        return corner;
+    }
+};
+
+}
@@ -1,4 +1,7 @@
 #pragma once
+#include <unordered_map>
+#include <vector>
+
 #include "../../vec.hpp"
 #include "../../math.hpp"
 
@@ -26,16 +29,39 @@ struct CardGeometryGenerator
         return quality + 5;
     }
 
-    void generateArc(sf::VertexArray* va, Vec2f center, float angle_start, uint32_t* global_index, Vec2f offset) const
+    /** Returns the points of a unit quarter circle starting at angle 0.
+     *
+     * They only depend on the quality so they are computed once and shared by all the cards,
+     * which are built by the render thread only.
+     */
+    [[nodiscard]]
+    static std::vector<Vec2f> const& getUnitArc(uint32_t const quality)
     {
-        uint32_t const arc_quality = quality / 4;
-        float const da{Constant32::TwoPi / static_cast<float>(quality)};
-        sf::VertexArray& vertex_array{*va};
+        static std::unordered_map<uint32_t, std::vector<Vec2f>> arcs;
+        std::vector<Vec2f>& arc = arcs[quality];
+        if (arc.empty()) {
+            uint32_t const arc_quality = quality / 4;
+            float const da{Constant32::TwoPi / static_cast<float>(quality)};
+            arc.reserve(arc_quality + 1);
+            for (uint32_t i(0); i < arc_quality + 1; ++i) {
+                float const angle = static_cast<float>(i) * da;
+                arc.emplace_back(std::cos(angle), std::sin(angle));
+            }
+        }
+        return arc;
+    }
 
-        for (uint32_t i(0); i < arc_quality + 1; ++i) {
-            const auto fi = static_cast<float>(i);
-            const float angle = angle_start + fi * da;
-            vertex_array[*global_index].position = center + radius * Vec2f{std::cos(angle), std::sin(angle)} + offset;
+    /// Generates the arc of the corner @p quarter, the quarter circles are numbered clockwise from angle 0
+    void generateArc(sf::VertexArray* va, std::vector<Vec2f> const& arc, Vec2f center, uint32_t quarter, uint32_t* global_index, Vec2f offset) const
+    {
+        sf::VertexArray& vertex_array{*va};
+        for (Vec2f const p : arc) {
+            // Rotate the unit arc by quarter * 90 degrees
+            Vec2f const direction = (quarter == 0) ? p
+                                  : (quarter == 1) ? Vec2f{-p.y, p.x}
+                                  : (quarter == 2) ? Vec2f{-p.x, -p.y}
+                                  :                  Vec2f{p.y, -p.x};
+            vertex_array[*global_index].position = center + radius * direction + offset;
             vertex_array[*global_index].color = color;
             (*global_index) += 1 + skip;
         }
@@ -45,15 +71,16 @@ struct CardGeometryGenerator
     {
         uint32_t global_index{start};
         sf::VertexArray& vertex_array{*va};
+        std::vector<Vec2f> const& arc = getUnitArc(quality);
 
         // Bottom right
-        generateArc(va, {size.x - radius, size.y - radius}, 0.0f, &global_index, offset);
+        generateArc(va, arc, {size.x - radius, size.y - radius}, 0, &global_index, offset);
         // Bottom left
-        generateArc(va, {radius, size.y - radius}, Constant32::Pi * 0.5f, &global_index, offset);
+        generateArc(va, arc, {radius, size.y - radius}, 1, &global_index, offset);
         // Top left
-        generateArc(va, {radius, radius}, Constant32::Pi, &global_index, offset);
+        generateArc(va, arc, {radius, radius}, 2, &global_index, offset);
         // Top right
-        generateArc(va, {size.x - radius, radius}, Constant32::Pi * 1.5f, &global_index, offset);
+        generateArc(va, arc, {size.x - radius, radius}, 3, &global_index, offset);
 
         // Close the loop
         vertex_array[global_index].position = {size.x + offset.x, size.y - radius + offset.y};
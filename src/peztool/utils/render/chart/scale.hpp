@@ -1,5 +1,10 @@
 #pragma once
+#include <array>
+#include <format>
+
+#include "../frame_quad_vertex_array.hpp"
 #include "../quad_vertex_array.hpp"
+#include "../text_run.hpp"
 
 
 namespace pez
@@ -30,6 +35,8 @@ struct Scale final : public sf::Drawable, sf::Transformable
     bool x_ticks = true;
     /// The labels height
     float label_height = 0.0f;
+    /// The value labels, laid out when the geometry is updated
+    std::vector<TextRun> labels;
 
     sf::Font const* font;
 
@@ -39,8 +46,7 @@ struct Scale final : public sf::Drawable, sf::Transformable
         , font{font_}
     {
         if (font) {
-            sf::Text value_label{*font, "8", 32};
-            value_label.setScale({text_scale, text_scale});
+            TextRun const value_label{*font, "8", 32};
             label_height = 3.0f * offset + value_label.getLocalBounds().size.y * text_scale;
         }
     }
@@ -56,31 +62,47 @@ struct Scale final : public sf::Drawable, sf::Transformable
             generateValueTicks();
             ticks.setAllQuadColor({255, 255, 255, 120});
         }
+        updateLabels();
     }
 
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override
     {
         states.transform *= getTransform();
         target.draw(ticks, states);
-
-        if (font) {
-            sf::Text value_label{*font, "", 32};
-            foreachValueTick([&](float const value, float const y) {
-                value_label.setString(std::format("{:.0f}", value));
-                auto const bounds = value_label.getLocalBounds();
-                if (y - bounds.size.y * text_scale - offset < 0.0f) {
-                    return;
-                }
-                value_label.setOrigin(bounds.position + Vec2f{0.0f, bounds.size.y});
-                value_label.setScale({text_scale, text_scale});
-                value_label.setPosition({offset, y - offset});
-                value_label.setFillColor({255, 255, 255, 50});
-                target.draw(value_label, states);
-            });
+        for (TextRun const& label : labels) {
+            target.draw(label, states);
         }
     }
 
 private:
+    /// Lays out the value labels, runs are reused so unchanged values keep their glyphs
+    void updateLabels()
+    {
+        if (!font) {
+            return;
+        }
+        size_t count{0};
+        std::array<char, 32> buffer{};
+        foreachValueTick([&](float const value, float const y) {
+            if (count == labels.size()) {
+                labels.emplace_back(*font, "", 32);
+                labels.back().setScale({text_scale, text_scale});
+                labels.back().setFillColor({255, 255, 255, 50});
+            }
+            TextRun& label = labels[count];
+            auto const result = std::format_to_n(buffer.data(), buffer.size(), "{:.0f}", value);
+            label.setString({buffer.data(), static_cast<size_t>(result.out - buffer.data())});
+            auto const bounds = label.getLocalBounds();
+            if (y - bounds.size.y * text_scale - offset < 0.0f) {
+                return;
+            }
+            label.setOrigin(bounds.position + Vec2f{0.0f, bounds.size.y});
+            label.setPosition({offset, y - offset});
+            ++count;
+        });
+        labels.erase(labels.begin() + static_cast<std::ptrdiff_t>(count), labels.end());
+    }
+
     /// Generates the geometry of the ticks for the X axis
     void generatePeriodTicks(size_t const value_count, size_t const value_idx)
     {
@@ -104,7 +126,7 @@ private:
     /// Generates the geometry of the ticks for the Y axis
     void generateValueTicks()
     {
-        std::vector<float> ticks_y;
+        FrameVector<float> ticks_y;
         foreachValueTick([&ticks_y](float const, float const y) {
             ticks_y.push_back(y);
         });
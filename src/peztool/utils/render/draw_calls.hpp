@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+
+namespace pez
+{
+
+/** Counts the draw calls issued by the render helpers.
+ *
+ * Covers cards, card batches, text runs, frame quads, widget caches, blur passes, chart
+ * composition and the final window composite. Plain SFML drawables drawn directly (sf::Text,
+ * shapes, chart vertex arrays) are not counted, the total is a lower bound.
+ */
+struct DrawCalls
+{
+    static void add(uint64_t const count = 1)
+    {
+        s_count += count;
+    }
+
+    /// Returns the number of draw calls since the start of the application
+    [[nodiscard]]
+    static uint64_t getCount()
+    {
+        return s_count;
+    }
+
+private:
+    static inline uint64_t s_count = 0;
+};
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+
+#include "../frame_arena.hpp"
+#include "../vec.hpp"
+#include "./draw_calls.hpp"
+
+
+namespace pez
+{
+
+/** Quads built and drawn in the same frame, the vertices are allocated in the FrameArena.
+ *
+ * Same vertex layout as QuadVertexArray, for geometry that is not worth keeping between frames.
+ */
+struct FrameQuadVertexArray final : public sf::Drawable
+{
+    FrameVector<sf::Vertex> vertices;
+
+    explicit
+    FrameQuadVertexArray(size_t const quad_count_hint = 0)
+    {
+        vertices.reserve(quad_count_hint * 6);
+    }
+
+    size_t appendAlignedRectangle(Vec2f const size, Vec2f const pos)
+    {
+        size_t const quad_idx = getQuadCount();
+        Vec2f const half_size = size * 0.5f;
+        Vec2f const top_left  = pos - half_size;
+        Vec2f const bot_right = pos + half_size;
+        vertices.push_back({top_left});
+        vertices.push_back({{bot_right.x, top_left.y}});
+        vertices.push_back({bot_right});
+        vertices.push_back({bot_right});
+        vertices.push_back({top_left});
+        vertices.push_back({{top_left.x, bot_right.y}});
+        return quad_idx;
+    }
+
+    void setQuadColor(size_t const quad_idx, sf::Color const color)
+    {
+        size_t const vertex_index = quad_idx * 6;
+        for (size_t i{0}; i < 6; ++i) {
+            vertices[vertex_index + i].color = color;
+        }
+    }
+
+    [[nodiscard]]
+    size_t getQuadCount() const
+    {
+        return vertices.size() / 6;
+    }
+
+    void draw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    {
+        if (vertices.empty()) {
+            return;
+        }
+        target.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Triangles, states);
+        DrawCalls::add();
+    }
+};
+
+}
@@ -0,0 +1,245 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../vec.hpp"
+#include "./draw_calls.hpp"
+
+
+namespace pez
+{
+
+/** A single line text that keeps its laid out glyphs between frames.
+ *
+ * The geometry is keyed by font, character size and string. When only the string changes, the
+ * glyphs that kept their character and their pen position are left untouched, so a ticking
+ * timer only rewrites its last digits. Characters are bytes, as with sf::Text built from a
+ * std::string in the default locale.
+ */
+struct TextRun final : public sf::Drawable, public sf::Transformable
+{
+    explicit
+    TextRun(sf::Font const& font, std::string_view const str = {}, uint32_t const character_size = 30)
+        : m_font{&font}
+        , m_character_size{character_size}
+    {
+        setString(str);
+    }
+
+    void setString(std::string_view const str)
+    {
+        if (str != m_string) {
+            m_string.assign(str);
+            m_geometry_dirty = true;
+        }
+    }
+
+    void setFont(sf::Font const& font)
+    {
+        if (&font != m_font) {
+            m_font = &font;
+            invalidate();
+        }
+    }
+
+    void setCharacterSize(uint32_t const character_size)
+    {
+        if (character_size != m_character_size) {
+            m_character_size = character_size;
+            invalidate();
+        }
+    }
+
+    void setFillColor(sf::Color const color)
+    {
+        if (color == m_color) {
+            return;
+        }
+        m_color = color;
+        for (sf::Vertex& vertex : m_vertices) {
+            vertex.color = color;
+        }
+    }
+
+    [[nodiscard]]
+    std::string_view getString() const
+    {
+        return m_string;
+    }
+
+    [[nodiscard]]
+    uint32_t getCharacterSize() const
+    {
+        return m_character_size;
+    }
+
+    [[nodiscard]]
+    sf::Color getFillColor() const
+    {
+        return m_color;
+    }
+
+    /// Same as sf::Text::getLocalBounds
+    [[nodiscard]]
+    sf::FloatRect getLocalBounds() const
+    {
+        ensureGeometry();
+        return m_bounds;
+    }
+
+    /// Returns the number of glyphs rewritten since the run was created
+    [[nodiscard]]
+    size_t getRebuiltGlyphCount() const
+    {
+        return m_rebuilt_glyphs;
+    }
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+    {
+        ensureGeometry();
+        if (m_vertices.empty()) {
+            return;
+        }
+        states.transform *= getTransform();
+        states.texture = &m_font->getTexture(m_character_size);
+        target.draw(m_vertices.data(), m_vertices.size(), sf::PrimitiveType::Triangles, states);
+        DrawCalls::add();
+    }
+
+private:
+    struct Glyph
+    {
+        char32_t code = 0;
+        /// Pen position before and after the glyph
+        Vec2f    pen;
+        Vec2f    next;
+        /// Contribution to the bounds
+        Vec2f    min;
+        Vec2f    max;
+    };
+
+    sf::Font const* m_font;
+    uint32_t        m_character_size;
+    sf::Color       m_color = sf::Color::White;
+    std::string     m_string;
+
+    mutable std::vector<Glyph>      m_glyphs;
+    /// Six vertices per character, whitespaces get an empty quad
+    mutable std::vector<sf::Vertex> m_vertices;
+    mutable sf::FloatRect           m_bounds;
+    mutable uint32_t                m_texture_handle = 0;
+    mutable size_t                  m_valid_count = 0;
+    mutable size_t                  m_rebuilt_glyphs = 0;
+    mutable bool                    m_geometry_dirty = true;
+
+    void invalidate()
+    {
+        m_valid_count = 0;
+        m_geometry_dirty = true;
+    }
+
+    void ensureGeometry() const
+    {
+        // A reloaded font comes with a new texture, the whole run is laid out again
+        uint32_t const texture_handle = m_font->getTexture(m_character_size).getNativeHandle();
+        if (texture_handle != m_texture_handle) {
+            m_texture_handle = texture_handle;
+            m_valid_count = 0;
+            m_geometry_dirty = true;
+        }
+        if (!m_geometry_dirty) {
+            return;
+        }
+        m_geometry_dirty = false;
+
+        size_t const count = m_string.size();
+        m_glyphs.resize(count);
+        m_vertices.resize(count * 6);
+
+        auto const  size         = static_cast<float>(m_character_size);
+        float const whitespace   = m_font->getGlyph(U' ', m_character_size, false).advance;
+        float const line_spacing = m_font->getLineSpacing(m_character_size);
+
+        Vec2f    pen{0.0f, size};
+        char32_t previous = 0;
+        for (size_t i{0}; i < count; ++i) {
+            auto const code = static_cast<char32_t>(static_cast<unsigned char>(m_string[i]));
+            pen.x += m_font->getKerning(previous, code, m_character_size);
+            previous = code;
+
+            Glyph& glyph = m_glyphs[i];
+            if (i < m_valid_count && glyph.code == code && glyph.pen == pen) {
+                pen = glyph.next;
+                continue;
+            }
+            glyph.code = code;
+            glyph.pen  = pen;
+            writeGlyph(glyph, i, whitespace, line_spacing);
+            pen = glyph.next;
+            ++m_rebuilt_glyphs;
+        }
+        m_valid_count = count;
+        // Adding glyphs may have grown the font texture, the pixel coordinates are still valid
+        m_texture_handle = m_font->getTexture(m_character_size).getNativeHandle();
+        updateBounds();
+    }
+
+    void writeGlyph(Glyph& glyph, size_t const idx, float const whitespace, float const line_spacing) const
+    {
+        sf::Vertex* const quad = &m_vertices[idx * 6];
+        Vec2f const pen = glyph.pen;
+        if (glyph.code == U' ' || glyph.code == U'\t' || glyph.code == U'\n') {
+            if (glyph.code == U'\n') {
+                glyph.next = {0.0f, pen.y + line_spacing};
+            } else {
+                glyph.next = {pen.x + ((glyph.code == U' ') ? whitespace : 4.0f * whitespace), pen.y};
+            }
+            glyph.min = {std::min(pen.x, glyph.next.x), std::min(pen.y, glyph.next.y)};
+            glyph.max = {std::max(pen.x, glyph.next.x), std::max(pen.y, glyph.next.y)};
+            for (size_t v{0}; v < 6; ++v) {
+                quad[v] = sf::Vertex{pen, m_color, {}};
+            }
+            return;
+        }
+
+        sf::Glyph const& info = m_font->getGlyph(glyph.code, m_character_size, false);
+        glyph.next = {pen.x + info.advance, pen.y};
+        glyph.min  = pen + info.bounds.position;
+        glyph.max  = glyph.min + info.bounds.size;
+
+        // Same padding as sf::Text to avoid cutting the glyph edges
+        float constexpr padding = 1.0f;
+        Vec2f const top_left        = glyph.min - Vec2f{padding, padding};
+        Vec2f const bottom_right    = glyph.max + Vec2f{padding, padding};
+        Vec2f const uv_top_left     = static_cast<Vec2f>(info.textureRect.position) - Vec2f{padding, padding};
+        Vec2f const uv_bottom_right = static_cast<Vec2f>(info.textureRect.position + info.textureRect.size) + Vec2f{padding, padding};
+
+        quad[0] = sf::Vertex{top_left, m_color, uv_top_left};
+        quad[1] = sf::Vertex{{bottom_right.x, top_left.y}, m_color, {uv_bottom_right.x, uv_top_left.y}};
+        quad[2] = sf::Vertex{{top_left.x, bottom_right.y}, m_color, {uv_top_left.x, uv_bottom_right.y}};
+        quad[3] = quad[2];
+        quad[4] = quad[1];
+        quad[5] = sf::Vertex{bottom_right, m_color, uv_bottom_right};
+    }
+
+    void updateBounds() const
+    {
+        if (m_glyphs.empty()) {
+            m_bounds = {};
+            return;
+        }
+        auto const size = static_cast<float>(m_character_size);
+        Vec2f min{size, size};
+        Vec2f max{0.0f, 0.0f};
+        for (Glyph const& glyph : m_glyphs) {
+            min = {std::min(min.x, glyph.min.x), std::min(min.y, glyph.min.y)};
+            max = {std::max(max.x, glyph.max.x), std::max(max.y, glyph.max.y)};
+        }
+        m_bounds = {min, max - min};
+    }
+};
+
+}
@@ -1,30 +1,178 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <functional>
+#include <mutex>
+#include <span>
 
+#include "./mpsc_queue.hpp"
 
+
+/** Flushes the queues of all the signal types posted at least once.
+ *
+ * Called once per tick by the main thread, see Dispatcher::post.
+ */
+struct SignalQueues
+{
+    using FlushCallback = size_t(*)();
+
+    /// Delivers all the queued signals, returns their count
+    static size_t flush()
+    {
+        {
+            // Types can be registered by other threads, or by the subscribers called below
+            std::lock_guard lock(s_mutex);
+            s_flush_order = s_flush_callbacks;
+        }
+        size_t count = 0;
+        for (FlushCallback const callback : s_flush_order) {
+            count += callback();
+        }
+        return count;
+    }
+
+    static void add(FlushCallback const callback)
+    {
+        std::lock_guard lock(s_mutex);
+        s_flush_callbacks.push_back(callback);
+    }
+
+private:
+    static inline std::mutex                 s_mutex;
+    static inline std::vector<FlushCallback> s_flush_callbacks;
+    /// Copy of the callbacks used by flush, kept to avoid allocating each tick
+    static inline std::vector<FlushCallback> s_flush_order;
+};
+
+
+/** Delivers signals of type @p TSignal to their subscribers.
+ *
+ * emit calls the subscribers right away. post can be called from any thread, it adds the signal
+ * to a lock-free queue that the main thread drains once per tick, subscribers are then called
+ * with all the signals queued since the previous tick.
+ * Subscribing, unsubscribing and emitting are only done on the main thread.
+ */
 template<typename TSignal>
 struct Dispatcher
 {
 public:
+    using ID             = uint64_t;
     using SignalCallback = std::function<void(TSignal const&)>;
+    /// Receives the queued signals in posting order, or an emitted signal alone
+    using BatchCallback  = std::function<void(std::span<TSignal const>)>;
+
+    /// Default number of signals that can wait in the queue between two ticks
+    static constexpr size_t default_queue_capacity = 1024;
 
 public:
     static void emit(TSignal const& signal)
     {
-        for (auto const& l : s_listener) {
-            l(signal);
-        }
+        deliver(std::span<TSignal const>{&signal, 1});
+    }
+
+    /** Queues the signal, it is delivered at the start of the next tick. Does not allocate.
+     *
+     * @return false if the queue is full, the signal is then dropped
+     */
+    static bool post(TSignal signal)
+    {
+        return getQueue().ring.tryPush(std::move(signal));
+    }
+
+    static ID subscribe(SignalCallback callback)
+    {
+        s_listener.push_back({s_next_id, std::move(callback)});
+        return s_next_id++;
+    }
+
+    /// Subscribes to whole batches of signals, better suited for frequent signals
+    static ID subscribeBatch(BatchCallback callback)
+    {
+        s_batch_listener.push_back({s_next_id, std::move(callback)});
+        return s_next_id++;
+    }
+
+    static void unsubscribe(ID const id)
+    {
+        std::erase_if(s_listener, [id](Listener<SignalCallback> const& listener) { return listener.id == id; });
+        std::erase_if(s_batch_listener, [id](Listener<BatchCallback> const& listener) { return listener.id == id; });
     }
 
-    static void subscribe(SignalCallback callback)
+    /// Sets the queue capacity, has no effect once a signal of this type was posted
+    static void setQueueCapacity(size_t const capacity)
     {
-        s_listener.push_back(callback);
+        s_queue_capacity = capacity;
     }
 
 private:
-    static std::vector<SignalCallback> s_listener;
+    template<typename TCallback>
+    struct Listener
+    {
+        ID        id;
+        TCallback callback;
+    };
+
+    struct Queue
+    {
+        pez::MPSCQueue<TSignal> ring;
+        /// The signals being delivered, reused between ticks
+        std::vector<TSignal>    batch;
+
+        Queue()
+            : ring{s_queue_capacity}
+        {
+            SignalQueues::add(&Dispatcher::flush);
+        }
+    };
+
+    static std::vector<Listener<SignalCallback>> s_listener;
+    static std::vector<Listener<BatchCallback>>  s_batch_listener;
+    static ID                                    s_next_id;
+    static size_t                                s_queue_capacity;
+
+    /// Created by the first post, the initialization of function statics is thread safe
+    static Queue& getQueue()
+    {
+        static Queue queue;
+        return queue;
+    }
+
+    static size_t flush()
+    {
+        Queue& queue = getQueue();
+        queue.batch.clear();
+        TSignal signal;
+        while (queue.ring.tryPop(signal)) {
+            queue.batch.push_back(std::move(signal));
+        }
+        if (!queue.batch.empty()) {
+            deliver(queue.batch);
+        }
+        return queue.batch.size();
+    }
+
+    static void deliver(std::span<TSignal const> const signals)
+    {
+        // Indexes since subscribers can add other subscribers
+        for (size_t i{0}; i < s_batch_listener.size(); ++i) {
+            s_batch_listener[i].callback(signals);
+        }
+        for (size_t i{0}; i < s_listener.size(); ++i) {
+            for (TSignal const& signal : signals) {
+                s_listener[i].callback(signal);
+            }
+        }
+    }
 };
 
 template<typename TSignal>
-std::vector<typename Dispatcher<TSignal>::SignalCallback> Dispatcher<TSignal>::s_listener = {};
\ No newline at end of file
+std::vector<typename Dispatcher<TSignal>::template Listener<typename Dispatcher<TSignal>::SignalCallback>> Dispatcher<TSignal>::s_listener = {};
+
+template<typename TSignal>
+std::vector<typename Dispatcher<TSignal>::template Listener<typename Dispatcher<TSignal>::BatchCallback>> Dispatcher<TSignal>::s_batch_listener = {};
+
+template<typename TSignal>
+typename Dispatcher<TSignal>::ID Dispatcher<TSignal>::s_next_id = 0;
+
+template<typename TSignal>
+size_t Dispatcher<TSignal>::s_queue_capacity = Dispatcher<TSignal>::default_queue_capacity;
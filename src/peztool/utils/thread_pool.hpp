@@ -1,7 +1,9 @@
 #pragma once
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <functional>
-#include <queue>
+#include <memory>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -11,161 +13,247 @@
 namespace pez
 {
 
-struct TaskQueue
+/// Tracks a set of tasks, a thread can wait for all of them with ThreadPool::wait
+struct TaskGroup
 {
-    std::queue<std::function<void()>> m_tasks;
-    std::mutex                        m_mutex;
-    std::atomic<uint32_t>             m_remaining_tasks = 0;
+    TaskGroup() = default;
+    TaskGroup(TaskGroup const&) = delete;
+    TaskGroup& operator=(TaskGroup const&) = delete;
 
-    bool                    m_sleep = false;
-    std::mutex              m_sleep_mutex;
-    std::condition_variable m_sleep_condition;
-
-    template<typename TCallback>
-    void addTask(TCallback&& callback)
+    [[nodiscard]]
+    bool isDone()
     {
-        std::lock_guard<std::mutex> lock_guard{m_mutex};
-        m_tasks.push(std::forward<TCallback>(callback));
-        ++m_remaining_tasks;
+        std::lock_guard lock(m_mutex);
+        return m_remaining == 0;
     }
 
-    void getTask(std::function<void()>& target_callback)
-    {
-        {
-            std::lock_guard<std::mutex> lock_guard{m_mutex};
-            if (m_tasks.empty()) {
-                return;
-            }
-            target_callback = std::move(m_tasks.front());
-            m_tasks.pop();
-        }
-    }
+private:
+    friend struct ThreadPool;
 
-    void wait()
-    {
-        std::unique_lock lock(m_sleep_mutex);
-        if (m_sleep) {
-            m_sleep_condition.wait(lock, [this] { return !m_sleep; });
-        } else {
-            std::this_thread::yield();
-        }
-    }
-
-    void waitForCompletion() const
-    {
-        while (m_remaining_tasks > 0) {
-            std::this_thread::yield();
-        }
-    }
+    /// The count is only changed with the lock held, so the group can be destroyed as soon as a waiter sees zero
+    uint32_t                m_remaining = 0;
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
 
-    void workDone()
+    void add()
     {
-        --m_remaining_tasks;
+        std::lock_guard lock(m_mutex);
+        ++m_remaining;
     }
 
-    void sleep()
+    void done()
     {
-        m_sleep = true;
-    }
-
-    void wakeup()
-    {
-        m_sleep = false;
-        m_sleep_condition.notify_all();
+        std::lock_guard lock(m_mutex);
+        if (--m_remaining == 0) {
+            m_condition.notify_all();
+        }
     }
 };
 
-struct Worker
+struct Task
 {
-    uint64_t              m_id      = 0;
-    std::thread           m_thread;
-    std::function<void()> m_task    = nullptr;
-    bool                  m_running = true;
-    TaskQueue*            m_queue   = nullptr;
+    std::function<void()> callback;
+    TaskGroup*            group = nullptr;
+};
 
-    Worker() = default;
+/// Tasks of one worker, the owner takes the most recent ones and thieves the oldest ones
+struct TaskDeque
+{
+    std::deque<Task> m_tasks;
+    std::mutex       m_mutex;
 
-    Worker(TaskQueue& queue, uint64_t const id)
-        : m_id{id}
-        , m_queue{&queue}
+    void push(Task&& task)
     {
-        m_thread = std::thread([this](){
-            run();
-        });
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        m_tasks.push_back(std::move(task));
     }
 
-    void run()
+    bool pop(Task& task)
     {
-        while (m_running) {
-            m_queue->getTask(m_task);
-            if (m_task == nullptr) {
-                m_queue->wait();
-            } else {
-                m_task();
-                m_queue->workDone();
-                m_task = nullptr;
-            }
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        if (m_tasks.empty()) {
+            return false;
         }
+        task = std::move(m_tasks.back());
+        m_tasks.pop_back();
+        return true;
     }
 
-    void stop()
+    bool steal(Task& task)
     {
-        m_running = false;
-        m_thread.join();
+        std::lock_guard<std::mutex> lock_guard{m_mutex};
+        if (m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+        return true;
     }
 };
 
+/** Work stealing thread pool.
+ *
+ * Each worker has its own deque. Tasks added by a worker go to its deque, tasks added from other
+ * threads are spread over the workers. A worker without tasks steals from the others and parks on
+ * a condition variable once there is nothing left, idle workers use no CPU.
+ * A thread waiting for a TaskGroup runs queued tasks meanwhile, so waiting from a task is safe.
+ */
 struct ThreadPool final
 {
-    uint32_t            m_thread_count = 0;
-    TaskQueue           m_queue;
-    std::vector<Worker> m_workers;
+    uint32_t m_thread_count = 0;
 
     explicit
     ThreadPool(uint32_t const thread_count)
         : m_thread_count{thread_count}
     {
+        // One deque per worker, the calling threads use the first one when there is no worker
+        for (uint32_t i{std::max(thread_count, 1u)}; i--;) {
+            m_deques.push_back(std::make_unique<TaskDeque>());
+        }
         m_workers.reserve(thread_count);
-        for (uint32_t i{thread_count}; i--;) {
-            m_workers.emplace_back(m_queue, static_cast<uint32_t>(m_workers.size()));
+        for (uint32_t i{0}; i < thread_count; ++i) {
+            m_workers.emplace_back([this, i] {
+                run(i);
+            });
         }
     }
 
     ~ThreadPool()
     {
-        m_queue.wakeup();
-        for (Worker& worker : m_workers) {
-            worker.stop();
+        {
+            std::lock_guard lock(m_park_mutex);
+            m_running = false;
+        }
+        m_park_condition.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
         }
     }
 
+    /// Adds a task, @p group is notified when it is done
+    template<typename TCallback>
+    void addTask(TaskGroup& group, TCallback&& callback)
+    {
+        group.add();
+        push({std::forward<TCallback>(callback), &group});
+    }
+
+    /// Adds a task to the default group, see waitForCompletion
     template<typename TCallback>
     void addTask(TCallback&& callback)
     {
-        m_queue.addTask(std::forward<TCallback>(callback));
+        addTask(m_default_group, std::forward<TCallback>(callback));
+    }
+
+    /// Blocks until all the tasks of @p group are done, runs queued tasks meanwhile
+    void wait(TaskGroup& group)
+    {
+        Task task;
+        std::unique_lock lock(group.m_mutex);
+        while (group.m_remaining > 0) {
+            lock.unlock();
+            bool const found = tryGetTask(getLocalDeque(), task);
+            if (found) {
+                execute(task);
+            }
+            lock.lock();
+            if (!found) {
+                // The remaining tasks of the group are running on other threads
+                group.m_condition.wait(lock, [&group] { return group.m_remaining == 0; });
+            }
+        }
     }
 
+    /// Blocks until the tasks added without group are done
     void waitForCompletion()
     {
-        m_queue.waitForCompletion();
+        wait(m_default_group);
     }
 
+    /// Splits [0, element_count[ in one batch per worker, calls @p callback(start, end) for each and waits
     template<typename TCallback>
     void dispatch(size_t element_count, TCallback&& callback)
     {
-        const size_t batch_size = element_count / m_thread_count;
-        for (size_t i{0}; i < m_thread_count; ++i) {
-            const size_t start = batch_size * i;
-            const size_t end   = start + batch_size;
-            addTask([start, end, &callback](){ callback(start, end); });
+        size_t const batch_count = std::max(m_thread_count, 1u);
+        size_t const batch_size  = element_count / batch_count;
+        TaskGroup group;
+        if (batch_size > 0) {
+            for (size_t i{0}; i < batch_count; ++i) {
+                size_t const start = batch_size * i;
+                size_t const end   = start + batch_size;
+                addTask(group, [start, end, &callback](){ callback(start, end); });
+            }
         }
 
-        if (batch_size * m_thread_count < element_count) {
-            const uint32_t start = batch_size * m_thread_count;
-            callback(start, element_count);
+        if (batch_size * batch_count < element_count) {
+            callback(batch_size * batch_count, element_count);
         }
 
-        waitForCompletion();
+        wait(group);
+    }
+
+    /** Calls @p callback(start, end) on chunks of [begin, end[ of @p grain elements, the calling thread takes part.
+     *
+     * Chunks are claimed one by one, so threads that get cheap chunks take more of them. Can be
+     * called from a task.
+     *
+     * @param grain The chunk size, 0 picks one giving several chunks per thread
+     */
+    template<typename TCallback>
+    void parallelFor(size_t const begin, size_t const end, size_t grain, TCallback&& callback)
+    {
+        if (begin >= end) {
+            return;
+        }
+        size_t const count = end - begin;
+        if (grain == 0) {
+            grain = std::max(size_t{1}, count / (8 * (static_cast<size_t>(m_thread_count) + 1)));
+        }
+        size_t const chunk_count = (count + grain - 1) / grain;
+        std::atomic<size_t> next_chunk{0};
+        auto const work = [&] {
+            for (size_t chunk{next_chunk++}; chunk < chunk_count; chunk = next_chunk++) {
+                size_t const start = begin + chunk * grain;
+                callback(start, std::min(start + grain, end));
+            }
+        };
+
+        // The caller takes one share, helpers are only worth it if there is more than one chunk
+        TaskGroup group;
+        size_t const helper_count = std::min(static_cast<size_t>(m_thread_count), chunk_count - 1);
+        for (size_t i{0}; i < helper_count; ++i) {
+            addTask(group, work);
+        }
+        work();
+        wait(group);
+    }
+
+    /** Reduces [begin, end[ by chunks of @p grain elements, see parallelFor.
+     *
+     * @param identity  The neutral value of @p combine
+     * @param reduce    Called as reduce(start, end), returns the value of the chunk
+     * @param combine   Called as combine(a, b), chunk values are combined in order so the result does not depend on scheduling
+     */
+    template<typename T, typename TReduce, typename TCombine>
+    [[nodiscard]]
+    T parallelReduce(size_t const begin, size_t const end, size_t grain, T const& identity, TReduce&& reduce, TCombine&& combine)
+    {
+        if (begin >= end) {
+            return identity;
+        }
+        size_t const count = end - begin;
+        if (grain == 0) {
+            grain = std::max(size_t{1}, count / (8 * (static_cast<size_t>(m_thread_count) + 1)));
+        }
+        std::vector<T> chunk_values((count + grain - 1) / grain, identity);
+        parallelFor(begin, end, grain, [&](size_t const start, size_t const chunk_end) {
+            chunk_values[(start - begin) / grain] = reduce(start, chunk_end);
+        });
+        T result = identity;
+        for (T const& value : chunk_values) {
+            result = combine(result, value);
+        }
+        return result;
     }
 
     template<typename TContainer, typename TCallback>
@@ -178,15 +266,97 @@ struct ThreadPool final
         });
     }
 
-    void sleep()
+private:
+    std::vector<std::unique_ptr<TaskDeque>> m_deques;
+    std::vector<std::thread>                m_workers;
+    TaskGroup                               m_default_group;
+
+    /// Tasks pushed and not taken yet, workers only park when it is zero
+    std::atomic<int64_t>    m_queued_count{0};
+    std::atomic<uint32_t>   m_parked_count{0};
+    std::atomic<uint32_t>   m_next_deque{0};
+    bool                    m_running = true;
+    std::mutex              m_park_mutex;
+    std::condition_variable m_park_condition;
+
+    /// The pool and deque index of the current worker thread
+    static inline thread_local ThreadPool const* s_worker_pool = nullptr;
+    static inline thread_local uint32_t          s_worker_idx  = 0;
+
+    void run(uint32_t const worker_idx)
+    {
+        s_worker_pool = this;
+        s_worker_idx  = worker_idx;
+        Task task;
+        while (true) {
+            if (tryGetTask(worker_idx, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock lock(m_park_mutex);
+            m_parked_count.fetch_add(1);
+            m_park_condition.wait(lock, [this] {
+                return !m_running || m_queued_count.load() > 0;
+            });
+            m_parked_count.fetch_sub(1);
+            if (!m_running) {
+                return;
+            }
+        }
+    }
+
+    void push(Task&& task)
     {
-        waitForCompletion();
-        m_queue.sleep();
+        m_deques[getPushDeque()]->push(std::move(task));
+        m_queued_count.fetch_add(1);
+        if (m_parked_count.load() > 0) {
+            // Taking the lock ensures a worker cannot miss the notification between its check and its wait
+            { std::lock_guard lock(m_park_mutex); }
+            m_park_condition.notify_one();
+        }
     }
 
-    void wakeup()
+    /// Takes a task from @p deque_idx, else steals one from the other deques
+    bool tryGetTask(uint32_t const deque_idx, Task& task)
     {
-        m_queue.wakeup();
+        if (m_queued_count.load() == 0) {
+            return false;
+        }
+        auto const deque_count = static_cast<uint32_t>(m_deques.size());
+        if (m_deques[deque_idx]->pop(task)) {
+            m_queued_count.fetch_sub(1);
+            return true;
+        }
+        for (uint32_t i{1}; i < deque_count; ++i) {
+            if (m_deques[(deque_idx + i) % deque_count]->steal(task)) {
+                m_queued_count.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void execute(Task& task)
+    {
+        task.callback();
+        task.callback = nullptr;
+        task.group->done();
+    }
+
+    [[nodiscard]]
+    uint32_t getLocalDeque() const
+    {
+        return (s_worker_pool == this) ? s_worker_idx : 0;
+    }
+
+    /// Workers keep their tasks, other threads spread theirs
+    [[nodiscard]]
+    uint32_t getPushDeque()
+    {
+        if (s_worker_pool == this) {
+            return s_worker_idx;
+        }
+        return m_next_deque.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(m_deques.size());
     }
 };
 
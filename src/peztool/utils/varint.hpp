@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+
+namespace pez
+{
+
+/// LEB128 variable length integers, small values take a single byte
+namespace varint
+{
+
+/// Maps signed values to unsigned ones so that small magnitudes stay small (0, -1, 1, -2, ...)
+inline uint64_t zigzagEncode(int64_t const value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t const value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/// Appends the encoded value to the buffer
+inline void write(std::vector<uint8_t>& buffer, uint64_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<uint8_t>(value));
+}
+
+inline void writeSigned(std::vector<uint8_t>& buffer, int64_t const value)
+{
+    write(buffer, zigzagEncode(value));
+}
+
+/** Decodes a value and advances the cursor
+ *
+ * @param cursor The current read position, moved after the decoded value
+ * @param end The end of the readable range, decoding never reads past it
+ * @return The decoded value, 0 if the data is truncated
+ */
+inline uint64_t read(uint8_t const** cursor, uint8_t const* const end)
+{
+    uint64_t result = 0;
+    uint32_t shift  = 0;
+    uint8_t const* p = *cursor;
+    while (p < end && shift < 64) {
+        uint8_t const byte = *p++;
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *cursor = p;
+            return result;
+        }
+        shift += 7;
+    }
+    *cursor = end;
+    return 0;
+}
+
+inline int64_t readSigned(uint8_t const** cursor, uint8_t const* const end)
+{
+    return zigzagDecode(read(cursor, end));
+}
+
+}
+
+}
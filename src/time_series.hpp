@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+
+/// A history entry, the activity started at @p time_ms (milliseconds since epoch)
+struct TimePoint
+{
+    int64_t  time_ms{0};
+    uint16_t activity_idx{0};
+};
+
+/** Chronological list of entries stored as columns.
+ *
+ * Each entry takes 10 bytes and duration scans only touch the two dense arrays.
+ */
+struct TimeSeries
+{
+    std::vector<int64_t>  times_ms;
+    std::vector<uint16_t> activities;
+
+    void push_back(TimePoint const& time_point)
+    {
+        times_ms.push_back(time_point.time_ms);
+        activities.push_back(time_point.activity_idx);
+    }
+
+    /// Appends all the entries of @p other
+    void append(TimeSeries const& other)
+    {
+        times_ms.insert(times_ms.end(), other.times_ms.begin(), other.times_ms.end());
+        activities.insert(activities.end(), other.activities.begin(), other.activities.end());
+    }
+
+    void reserve(size_t const count)
+    {
+        times_ms.reserve(count);
+        activities.reserve(count);
+    }
+
+    void clear()
+    {
+        times_ms.clear();
+        activities.clear();
+    }
+
+    [[nodiscard]]
+    size_t size() const
+    {
+        return times_ms.size();
+    }
+
+    [[nodiscard]]
+    bool empty() const
+    {
+        return times_ms.empty();
+    }
+
+    [[nodiscard]]
+    TimePoint operator[](size_t const idx) const
+    {
+        return {times_ms[idx], activities[idx]};
+    }
+
+    [[nodiscard]]
+    TimePoint back() const
+    {
+        return {times_ms.back(), activities.back()};
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "peztool/core/static_interface.hpp"
+#include "peztool/utils/thread_pool.hpp"
+
+#include "./time_series.hpp"
+
+
+/** Level of detail pyramid over a chronological TimeSeries, used to draw long time ranges.
+ *
+ * Level 0 holds the slots themselves. Level k splits time in buckets of base_bucket_ms * 2^k,
+ * gives each bucket the activity that covers most of it and merges the consecutive buckets of
+ * the same activity in runs. Runs of a level are never shorter than its buckets (except the first
+ * one), so reading a range with the first level whose buckets are at least one pixel wide gives
+ * at most one run per pixel, whatever the length of the range.
+ */
+struct TimelinePyramid
+{
+    /// The bucket size of level 0, entries are saved with a one second resolution
+    static int64_t constexpr base_bucket_ms = 1000;
+
+    /// Builds all the levels from @p entries, slots are closed at @p end_ms
+    void build(TimeSeries const& entries, int64_t const end_ms)
+    {
+        m_levels.clear();
+        m_end_ms = end_ms;
+
+        TimeSeries base;
+        size_t const entry_count = entries.size();
+        for (size_t i{0}; i < entry_count && entries.times_ms[i] < end_ms; ++i) {
+            base.push_back(entries[i]);
+        }
+        if (base.empty()) {
+            return;
+        }
+
+        // Stop once a single bucket covers the whole history
+        int64_t const span_ms = end_ms - base.times_ms.front();
+        size_t level_count = 1;
+        for (int64_t bucket_ms{2 * base_bucket_ms}; bucket_ms < 2 * span_ms; bucket_ms *= 2) {
+            ++level_count;
+        }
+        m_levels.resize(level_count);
+        m_levels[0] = std::move(base);
+
+        auto const& activities = m_levels[0].activities;
+        auto const getMaxActivity = [&activities](size_t const start, size_t const end) {
+            return *std::max_element(activities.begin() + static_cast<ptrdiff_t>(start), activities.begin() + static_cast<ptrdiff_t>(end));
+        };
+        auto const buildLevels = [this](size_t const start, size_t const end, uint16_t const max_activity) {
+            std::vector<int64_t> durations(max_activity + 1, 0);
+            for (size_t i{start}; i < end; ++i) {
+                m_levels[i] = buildLevel(m_levels[0], base_bucket_ms << i, durations);
+            }
+        };
+
+        if (!pez::Singleton<pez::ThreadPool>::exists()) {
+            buildLevels(1, level_count, getMaxActivity(0, activities.size()));
+            return;
+        }
+        // Levels only read the slots so they are built in parallel, the finest ones take the longest
+        auto& thread_pool = pez::Singleton<pez::ThreadPool>::get();
+        uint16_t const max_activity = thread_pool.parallelReduce(0, activities.size(), 0, uint16_t{0}, getMaxActivity, [](uint16_t const a, uint16_t const b) {
+            return std::max(a, b);
+        });
+        thread_pool.parallelFor(1, level_count, 1, [&buildLevels, max_activity](size_t const start, size_t const end) {
+            buildLevels(start, end, max_activity);
+        });
+    }
+
+    void clear()
+    {
+        m_levels.clear();
+        m_end_ms = 0;
+    }
+
+    [[nodiscard]]
+    bool empty() const
+    {
+        return m_levels.empty();
+    }
+
+    [[nodiscard]]
+    size_t getLevelCount() const
+    {
+        return m_levels.size();
+    }
+
+    /// Returns the end of the last slot
+    [[nodiscard]]
+    int64_t getEnd() const
+    {
+        return m_end_ms;
+    }
+
+    /// Returns the finest level whose buckets are at least @p ms_per_pixel wide
+    [[nodiscard]]
+    size_t getLevel(double const ms_per_pixel) const
+    {
+        size_t level = 0;
+        for (double bucket_ms{base_bucket_ms}; level + 1 < m_levels.size() && bucket_ms < ms_per_pixel; bucket_ms *= 2.0) {
+            ++level;
+        }
+        return level;
+    }
+
+    /** Calls @p callback(start_ms, end_ms, activity_idx) for each run intersecting [begin_ms, end_ms[
+     *
+     * @param ms_per_pixel  The duration covered by one pixel, selects the level
+     */
+    template<typename TCallback>
+    void foreachRun(int64_t const begin_ms, int64_t const end_ms, double const ms_per_pixel, TCallback&& callback) const
+    {
+        if (m_levels.empty() || begin_ms >= std::min(end_ms, m_end_ms)) {
+            return;
+        }
+        TimeSeries const& level = m_levels[getLevel(ms_per_pixel)];
+        auto const& times = level.times_ms;
+        // Start with the run covering begin_ms
+        auto const it = std::upper_bound(times.begin(), times.end(), begin_ms);
+        size_t i = (it == times.begin()) ? 0 : static_cast<size_t>(std::distance(times.begin(), it)) - 1;
+        size_t const run_count = level.size();
+        for (; i < run_count && times[i] < end_ms; ++i) {
+            int64_t const run_end = (i + 1 < run_count) ? times[i + 1] : m_end_ms;
+            callback(times[i], run_end, level.activities[i]);
+        }
+    }
+
+private:
+    /// Runs of each level, a run lasts until the start of the next one
+    std::vector<TimeSeries> m_levels;
+    int64_t                 m_end_ms{0};
+
+    /** Splits the slots of @p base in buckets of @p bucket_ms and merges them in runs
+     *
+     * @param durations Per activity time spent in the current bucket, all zeros
+     */
+    [[nodiscard]]
+    TimeSeries buildLevel(TimeSeries const& base, int64_t const bucket_ms, std::vector<int64_t>& durations) const
+    {
+        TimeSeries level;
+        std::vector<uint16_t> touched;
+        auto const pushRun = [&level](int64_t const start_ms, uint16_t const activity_idx) {
+            if (level.empty() || level.activities.back() != activity_idx) {
+                level.push_back({start_ms, activity_idx});
+            }
+        };
+
+        int64_t const first_ms = base.times_ms.front();
+        int64_t bucket_start = first_ms - (first_ms % bucket_ms + bucket_ms) % bucket_ms;
+        auto const closeBucket = [&]() {
+            uint16_t dominant = touched.front();
+            for (uint16_t const activity_idx : touched) {
+                if (durations[activity_idx] > durations[dominant]) {
+                    dominant = activity_idx;
+                }
+            }
+            // Only reset once the dominant is known, it is compared to until the end
+            for (uint16_t const activity_idx : touched) {
+                durations[activity_idx] = 0;
+            }
+            touched.clear();
+            pushRun(std::max(bucket_start, first_ms), dominant);
+            bucket_start += bucket_ms;
+        };
+
+        size_t const slot_count = base.size();
+        for (size_t i{0}; i < slot_count; ++i) {
+            uint16_t const activity_idx = base.activities[i];
+            int64_t start = base.times_ms[i];
+            int64_t const stop = (i + 1 < slot_count) ? base.times_ms[i + 1] : m_end_ms;
+            while (start < stop) {
+                // Whole buckets covered by the slot are its own, no need to visit them one by one
+                if (touched.empty() && stop - bucket_start >= bucket_ms) {
+                    pushRun(std::max(bucket_start, first_ms), activity_idx);
+                    bucket_start += ((stop - bucket_start) / bucket_ms) * bucket_ms;
+                    start = bucket_start;
+                    continue;
+                }
+                int64_t const bucket_end = bucket_start + bucket_ms;
+                int64_t const segment_end = std::min(stop, bucket_end);
+                if (durations[activity_idx] == 0) {
+                    touched.push_back(activity_idx);
+                }
+                durations[activity_idx] += segment_end - start;
+                start = segment_end;
+                if (segment_end == bucket_end) {
+                    closeBucket();
+                }
+            }
+        }
+        // The last bucket is only partially covered
+        if (!touched.empty()) {
+            closeBucket();
+        }
+        return level;
+    }
+};
@@ -3,6 +3,7 @@
 #include "./ui_common.hpp"
 #include "peztool/utils/color_utils.hpp"
 #include "peztool/utils/interpolation/standard_interpolated_value.hpp"
+#include "peztool/utils/render/text_run.hpp"
 #include "standard/widget.hpp"
 #include "utils.hpp"
 
@@ -12,10 +13,6 @@ struct ActivityBackground : public sf::Transformable, public sf::Drawable
     static float constexpr text_scale_f = 0.3f;
     static Vec2f constexpr text_scale   = {text_scale_f, text_scale_f};
 
-    std::string activity_label;
-
-    sf::Font const& font_title;
-    sf::Font const& font_timer;
     pez::CardOutlined background;
 
     float duration = 0.0f;
@@ -23,20 +20,59 @@ struct ActivityBackground : public sf::Transformable, public sf::Drawable
 
     explicit
     ActivityBackground(pez::ResourcesStore const& store, Vec2f const size_)
-        : font_title{*store.getFont("font_medium")}
-        , font_timer{*store.getFont("font_mono")}
-        , background{ui::createBackground(size_)}
+        : background{ui::createBackground(size_)}
+        , m_title{*store.getFont("font_medium"), "", 160}
+        , m_percent{*store.getFont("font_mono"), "", 100}
+        , m_duration{*store.getFont("font_mono"), "00:00:00", 150}
     {
+        sf::Color const label_color = pez::setAlpha(sf::Color::White, 200);
+        m_title.setScale(text_scale);
+        m_title.setFillColor(label_color);
+        m_percent.setScale(text_scale);
+        m_percent.setFillColor(label_color);
+        m_duration.setScale(text_scale);
+        m_duration.setFillColor(pez::setAlpha(sf::Color::White, 150));
+        // The timer is centered as if all its digits had the same width
+        auto const bounds = m_duration.getLocalBounds();
+        m_duration.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
+        updateLabels();
+    }
 
+    /// Adds the background card, drawn below the labels
+    void addCards(pez::CardBatch& batch, sf::Transform const& transform) const
+    {
+        batch.add(background, transform * getTransform());
     }
 
+    /// Draws the labels, the background card is drawn by addCards
     void draw(sf::RenderTarget& target, sf::RenderStates states) const override
     {
         states.transform *= getTransform();
-        target.draw(background, states);
+        target.draw(m_title, states);
+        target.draw(m_percent, states);
+        target.draw(m_duration, states);
+    }
 
-        drawTitle(target, states);
-        drawDuration(target, states);
+    void setLabel(std::string_view const label)
+    {
+        m_title.setString(label);
+        auto const bounds = m_title.getLocalBounds();
+        m_title.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
+    }
+
+    /// Updates the labels from the current duration, percent and size
+    void updateLabels()
+    {
+        Vec2f const size = getSize();
+        m_title.setPosition({size.x * 0.5f, ui::margin});
+
+        m_percent.setString(percentToString(percent, m_buffer));
+        auto const bounds = m_percent.getLocalBounds();
+        m_percent.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
+        m_percent.setPosition({size.x * 0.5f, size.y - ui::margin - bounds.size.y * text_scale_f});
+
+        m_duration.setString(timeToString(duration, m_buffer));
+        m_duration.setPosition(size * 0.5f);
     }
 
     void setShadowOffset(Vec2f const offset)
@@ -65,42 +101,11 @@ struct ActivityBackground : public sf::Transformable, public sf::Drawable
         return background.getOutlineSize();
     }
 
-    void drawTitle(sf::RenderTarget& target, sf::RenderStates const& states) const
-    {
-        sf::Text title{font_title, activity_label, 160};
-        title.setScale(text_scale);
-        title.setFillColor(pez::setAlpha(sf::Color::White, 200));
-        {
-            auto const bounds = title.getLocalBounds();
-            title.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
-        }
-        title.setPosition({getSize().x * 0.5f, ui::margin});
-        target.draw(title, states);
-
-        sf::Text percent_label{font_timer, std::format("{:.0f}%", percent), 100};
-        percent_label.setScale(text_scale);
-        percent_label.setFillColor(pez::setAlpha(sf::Color::White, 200));
-        {
-            auto const bounds = percent_label.getLocalBounds();
-            percent_label.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
-            percent_label.setPosition({getSize().x * 0.5f, getSize().y - ui::margin - bounds.size.y * text_scale_f});
-        }
-        target.draw(percent_label, states);
-    }
-
-    void drawDuration(sf::RenderTarget& target, sf::RenderStates const& states) const
-    {
-        sf::Text text{font_timer, "00:00:00", 150};
-        text.setScale(text_scale);
-        text.setFillColor(pez::setAlpha(sf::Color::White, 150));
-        auto const bounds = text.getLocalBounds();
-        text.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, 0.0f});
-        text.setString(timeToString(duration));
-
-        Vec2f const size = getSize();
-        text.setPosition(size * 0.5f);
-        target.draw(text, states);
-    }
+private:
+    pez::TextRun m_title;
+    pez::TextRun m_percent;
+    pez::TextRun m_duration;
+    LabelBuffer  m_buffer{};
 };
 
 
@@ -140,7 +145,16 @@ struct ActivityButton final : ui::Widget
         , font{*store.getFont("font_medium")}
         , history{&history_}
         , background{store, size_}
+        , m_active_label{font, "Active", 150}
+        , m_led{2.0f * Vec2f{led_radius, led_radius}, led_radius, sf::Color::Green}
     {
+        m_led.shadow_color = sf::Color::Green;
+        m_led.setShadowSize(16.0f);
+        m_active_label.setScale(ActivityBackground::text_scale);
+        m_active_label.setFillColor(pez::setAlpha(sf::Color::White, 200));
+        auto const bounds = m_active_label.getLocalBounds();
+        m_active_label.setOrigin(bounds.position + bounds.size * 0.5f);
+
         Vec2f const background_size = background.getSize();
         background.setOrigin(background_size * 0.5f);
         background.setPosition(background_size);
@@ -166,6 +180,11 @@ struct ActivityButton final : ui::Widget
         outline.setInterpolationFunction(interpolation_function);
         outline.setValueDirect(0.0f);
         outline.useRealtime();
+
+        trackInterpolation(highlight_offset);
+        trackInterpolation(highlight_scale);
+        trackInterpolation(background_height);
+        trackInterpolation(outline);
     }
 
     void onUpdate(float const dt) override
@@ -184,29 +203,31 @@ struct ActivityButton final : ui::Widget
 
         background.duration = history->getDuration(activity_idx);
         background.percent = (background.duration / Date::now().getTimeAsSeconds()) * 100.0f;
-    }
-
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
-    {
-        float constexpr led_radius = 10.0f;
-        float constexpr led_offset = 40.0f;
-
-        sf::Text text{font, "Active", 150};
-        text.setScale(ActivityBackground::text_scale);
-        auto const bounds = text.getLocalBounds();
-        text.setOrigin(bounds.position + bounds.size * 0.5f);
+        background.updateLabels();
 
         float const text_offset = size->y - background.getSize().y;
-        text.setPosition({size->x * 0.5f + led_offset * 0.25f, size->y * 0.7f + text_offset});
-        text.setFillColor(pez::setAlpha(sf::Color::White, 200));
-        target.draw(text, states);
+        m_active_label.setPosition({size->x * 0.5f + led_offset * 0.25f, size->y * 0.7f + text_offset});
+        float const label_width = m_active_label.getLocalBounds().size.x;
+        m_led.setPosition(m_active_label.getPosition() - Vec2f{label_width * ActivityBackground::text_scale_f * 0.5f + led_offset, 8.0f});
+        // Labels show whole seconds and whole percents
+        auto const displayed_seconds = static_cast<int32_t>(background.duration);
+        auto const displayed_percent = static_cast<int32_t>(std::round(background.percent));
+        if (displayed_seconds != m_displayed_seconds || displayed_percent != m_displayed_percent) {
+            m_displayed_seconds = displayed_seconds;
+            m_displayed_percent = displayed_percent;
+            markDirty();
+        }
+    }
 
-        pez::Card led{2.0f * Vec2f{led_radius, led_radius}, led_radius, sf::Color::Green};
-        led.shadow_color = sf::Color::Green;
-        led.setShadowSize(16.0f);
-        led.setPosition(text.getPosition() - Vec2f{bounds.size.x * ActivityBackground::text_scale_f * 0.5f + led_offset, 8.0f});
-        target.draw(led, states);
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
+    {
+        batch.add(m_led, transform);
+        background.addCards(batch, transform);
+    }
 
+    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    {
+        target.draw(m_active_label, states);
         target.draw(background, states);
     }
 
@@ -248,6 +269,14 @@ struct ActivityButton final : ui::Widget
     }
 
 private:
+    static float constexpr led_radius = 10.0f;
+    static float constexpr led_offset = 40.0f;
+
+    pez::TextRun m_active_label;
+    pez::Card    m_led;
+    int32_t      m_displayed_seconds = -1;
+    int32_t      m_displayed_percent = -1;
+
     void highlight()
     {
         highlight_offset = -ui::margin * 0.25f;
@@ -1,6 +1,8 @@
 #pragma once
 #include "peztool/utils/interpolation/standard_interpolated_value.hpp"
+#include "peztool/utils/render/text_run.hpp"
 #include "standard/widget.hpp"
+#include "utils.hpp"
 
 #include "./ui_common.hpp"
 #include "./time_bar.hpp"
@@ -9,6 +11,7 @@
 struct ActivityInfo final : sf::Transformable, sf::Drawable
 {
     static Vec2f constexpr s_size{300.0f, 160.0f};
+    static float constexpr s_margin{2.0f * ui::element_spacing};
 
     std::vector<Activity> const* activities;
 
@@ -26,7 +29,15 @@ struct ActivityInfo final : sf::Transformable, sf::Drawable
         : activities{&activities_}
         , font{font_}
         , background{s_size, ui::background_radius, {200, 200, 200}}
+        , m_name{font_, "", ui::info_box_title_size}
+        , m_percent{font_, "", ui::info_box_value_size}
+        , m_duration{font_, "", ui::info_box_small_size}
     {
+        m_name.setPosition({s_size.x * 0.5f, s_margin});
+        m_percent.setPosition(s_size * 0.5f);
+        m_duration.setPosition({s_size.x * 0.5f, s_size.y - s_margin});
+        m_duration.setFillColor(pez::setAlpha(sf::Color::White, 150));
+
         setOrigin({s_size.x * 0.5f, 0.0f});
         background.setShadowSize(40.0f);
         background.shadow_offset = {0.0f, 10.0f};
@@ -47,35 +58,9 @@ struct ActivityInfo final : sf::Transformable, sf::Drawable
     {
         states.transform *= getTransform();
         target.draw(background, states);
-
-        float constexpr margin{2.0f * ui::element_spacing};
-
-        Activity const& current_activity = (*activities)[current_hover.activity_idx];
-        sf::Text text{font, current_activity.name, ui::info_box_title_size};
-        ui::setOrigin(text, ui::origin::Mode::TopCenter);
-        text.setPosition({s_size.x * 0.5f, margin});
-        target.draw(text, states);
-
-        text.setCharacterSize(ui::info_box_value_size);
-        text.setFillColor(current_activity.color);
-        text.setString(std::format("{:.0f}%", current_hover.ratio * 100.0f));
-        {
-            auto const bounds = text.getLocalBounds();
-            text.setOrigin(bounds.position + bounds.size * 0.5f);
-            text.setPosition(s_size * 0.5f);
-            target.draw(text, states);
-        }
-
-        text.setCharacterSize(ui::info_box_small_size);
-        text.setFillColor(pez::setAlpha(sf::Color::White, 150));
-        text.setString(timeToString(current_hover.duration));
-        {
-            auto const bounds = text.getLocalBounds();
-            text.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, bounds.size.y});
-            float const slot_times_y = s_size.y - margin;
-            text.setPosition({s_size.x * 0.5f, slot_times_y});
-            target.draw(text, states);
-        }
+        target.draw(m_name, states);
+        target.draw(m_percent, states);
+        target.draw(m_duration, states);
     }
 
     void setHover(TimeBar::ActivityHover const& hover, Vec2f const position_)
@@ -83,10 +68,18 @@ struct ActivityInfo final : sf::Transformable, sf::Drawable
         if (hover.x != current_hover.x) {
             position.setValueDirect(position_);
             current_hover = hover;
+            updateLabels();
             setVisible(true);
         }
     }
 
+    /// Returns the area covered by the background once fully shown
+    [[nodiscard]]
+    sf::FloatRect getFullBounds() const
+    {
+        return {getPosition() - getOrigin(), s_size};
+    }
+
     void setVisible(bool const v)
     {
         if (v != visible) {
@@ -99,4 +92,30 @@ struct ActivityInfo final : sf::Transformable, sf::Drawable
             scale = 0.0f;
         }
     }
+
+private:
+    pez::TextRun m_name;
+    pez::TextRun m_percent;
+    pez::TextRun m_duration;
+    LabelBuffer  m_buffer{};
+
+    void updateLabels()
+    {
+        Activity const& current_activity = (*activities)[current_hover.activity_idx];
+        m_name.setString(current_activity.name);
+        ui::setOrigin(m_name, ui::origin::Mode::TopCenter);
+
+        m_percent.setFillColor(current_activity.color);
+        m_percent.setString(percentToString(current_hover.ratio * 100.0f, m_buffer));
+        {
+            auto const bounds = m_percent.getLocalBounds();
+            m_percent.setOrigin(bounds.position + bounds.size * 0.5f);
+        }
+
+        m_duration.setString(timeToString(current_hover.duration, m_buffer));
+        {
+            auto const bounds = m_duration.getLocalBounds();
+            m_duration.setOrigin(bounds.position + Vec2f{bounds.size.x * 0.5f, bounds.size.y});
+        }
+    }
 };
@@ -20,9 +20,9 @@ struct Container final : ui::Widget
         background.setFillColor({150, 150, 150});
     }
 
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
     {
-        target.draw(background, states);
+        batch.add(background, transform);
     }
 
     bool onClick(Vec2f const) override
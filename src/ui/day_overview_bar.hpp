@@ -1,6 +1,7 @@
 #pragma once
 #include "standard/widget.hpp"
 #include "shader/hatch.hpp"
+#include "peztool/utils/render/frame_quad_vertex_array.hpp"
 
 #include "./ui_common.hpp"
 #include "./history.hpp"
@@ -23,7 +24,12 @@ struct DayOverviewBar final : ui::Widget
 
     // Render
     pez::CardOutlined background;
+    /// The final chart, the baked texture with the ongoing slot on top
     sf::RenderTexture chart_texture;
+    /// Hatch background and closed slots, closed slots never change so they are only drawn once
+    sf::RenderTexture baked_texture;
+    /// The card showing the chart texture
+    pez::Card chart;
 
     // Hover
     std::optional<SlotHover> slot_hover;
@@ -37,57 +43,69 @@ struct DayOverviewBar final : ui::Widget
         , background{ui::createBackground(size_)}
     {
         auto const texture_size = static_cast<Vec2u>(getAvailableSize());
-        if (!chart_texture.resize(texture_size)) {
+        if (!chart_texture.resize(texture_size) || !baked_texture.resize(texture_size)) {
             std::cout << "Unable to create chart texture" << std::endl;
         }
 
+        chart.setShape(getAvailableSize(), ui::background_radius - ui::element_spacing);
+        chart.setColor(sf::Color::White);
+        chart.setTexture(&chart_texture.getTexture());
+        chart.shadow_offset = {0.0f, 2.0f};
+        chart.setPosition({ui::element_spacing, ui::element_spacing});
+
         shader.setRenderSize(size_);
     }
 
-    void onUpdate(float const dt) override
+    /// Forces the closed slots to be redrawn, for instance if activity colors changed
+    void invalidate()
     {
-        size_t const entry_count = history->entries.size();
-        pez::QuadVertexArray vertex_array;
-
-        Vec2f const available_size = getAvailableSize();
-        float constexpr day_seconds = 3600.0f * 24.0f;
-
-        chart_texture.clear({50, 50, 50});
-        sf::RectangleShape const hatch_rect{*size};
-        chart_texture.draw(hatch_rect, shader.get());
-
-        auto const createSlot = [&](float const start_time, float const end_time, sf::Color const color) {
-            float const  x_start   = available_size.x * (start_time / day_seconds);
-            float const  x_end     = available_size.x * (end_time / day_seconds);
-            Vec2f const  slot_size = {x_end - x_start, available_size.y};
-            size_t const idx       = vertex_array.appendAlignedRectangle(slot_size, Vec2f{x_start, 0.0f} + slot_size * 0.5f);
-            vertex_array.setQuadColor(idx, color);
-        };
+        m_baked       = false;
+        m_baked_count = 0;
+        m_open_slot_x = {-1.0f, -1.0f};
+    }
 
+    void onUpdate(float const dt) override
+    {
         auto const& entries = history->entries;
-        auto const getSlotColor = [&](size_t const slot_idx) -> sf::Color {
-            size_t const activity_idx = entries[slot_idx].activity_idx;
-            return (*activities)[activity_idx].color;
-        };
+        size_t const entry_count  = entries.size();
+        size_t const closed_count = entry_count - 1;
+        // The history only grows during a day, the baked texture is reset with the day
+        if (history->getDayStart() != m_baked_day_start || closed_count < m_baked_count) {
+            m_baked_day_start = history->getDayStart();
+            invalidate();
+        }
+
+        bool const bake_needed = !m_baked || (m_baked_count < closed_count);
+        if (bake_needed) {
+            bakeClosedSlots();
+        }
 
-        for (size_t i = 0; i < entry_count - 1; ++i) {
-            createSlot(entries[i].date.getTimeAsSeconds(), entries[i + 1].date.getTimeAsSeconds(), getSlotColor(i));
+        // Only the ongoing slot changes, the chart is only recomposed when it covers new pixels
+        Vec2f const open_slot_x = getSlotX(getDayTime(entries.times_ms.back()), getDayTime(Date::nowEpochMs()));
+        Vec2f const open_slot_pixels = {std::round(open_slot_x.x), std::round(open_slot_x.y)};
+        if (!bake_needed && open_slot_pixels == m_open_slot_x) {
+            return;
         }
-        createSlot(entries.back().date.getTimeAsSeconds(), Date::now().getTimeAsSeconds(), getSlotColor(entry_count - 1));
+        m_open_slot_x = open_slot_pixels;
+
+        chart_texture.clear();
+        chart_texture.draw(sf::Sprite{baked_texture.getTexture()});
+        pez::DrawCalls::add();
+        pez::FrameQuadVertexArray vertex_array{1};
+        appendSlot(vertex_array, open_slot_x, getSlotColor(entry_count - 1));
         chart_texture.draw(vertex_array);
         chart_texture.display();
+        markDirty();
+    }
+
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
+    {
+        batch.add(background, transform);
     }
 
     void onDraw(sf::RenderTarget& target, sf::RenderStates states) const override
     {
         states.texture = nullptr;
-        target.draw(background, states);
-
-        Vec2f const card_size = getAvailableSize();
-        pez::Card chart{card_size, ui::background_radius - ui::element_spacing, sf::Color::White};
-        chart.setTexture(&chart_texture.getTexture());
-        chart.shadow_offset = {0.0f, 2.0f};
-        chart.setPosition({ui::element_spacing, ui::element_spacing});
         target.draw(chart, states);
     }
 
@@ -107,6 +125,65 @@ struct DayOverviewBar final : ui::Widget
     }
 
 private:
+    /// True once the background is drawn in the baked texture
+    bool    m_baked{false};
+    /// Number of closed slots already drawn in the baked texture
+    size_t  m_baked_count{0};
+    int64_t m_baked_day_start{0};
+    /// Rounded pixel range of the ongoing slot in the current chart
+    Vec2f   m_open_slot_x{-1.0f, -1.0f};
+
+    /// Draws the slots closed since the last bake, redraws everything if the texture was invalidated
+    void bakeClosedSlots()
+    {
+        auto const& entries = history->entries;
+        size_t const closed_count = entries.size() - 1;
+        if (!m_baked) {
+            baked_texture.clear({50, 50, 50});
+            sf::RectangleShape const hatch_rect{*size};
+            baked_texture.draw(hatch_rect, shader.get());
+            pez::DrawCalls::add();
+            m_baked = true;
+        }
+
+        pez::FrameQuadVertexArray vertex_array{closed_count - m_baked_count};
+        for (size_t i{m_baked_count}; i < closed_count; ++i) {
+            appendSlot(vertex_array, getSlotX(getDayTime(entries.times_ms[i]), getDayTime(entries.times_ms[i + 1])), getSlotColor(i));
+        }
+        baked_texture.draw(vertex_array);
+        baked_texture.display();
+        m_baked_count = closed_count;
+    }
+
+    /// Returns the pixel range of a slot in the chart textures
+    [[nodiscard]]
+    Vec2f getSlotX(float const start_time, float const end_time) const
+    {
+        float constexpr day_seconds = 3600.0f * 24.0f;
+        float const available_width = getAvailableSize().x;
+        return {available_width * (start_time / day_seconds), available_width * (end_time / day_seconds)};
+    }
+
+    void appendSlot(pez::FrameQuadVertexArray& vertex_array, Vec2f const slot_x, sf::Color const color) const
+    {
+        Vec2f const  slot_size = {slot_x.y - slot_x.x, getAvailableSize().y};
+        size_t const idx       = vertex_array.appendAlignedRectangle(slot_size, Vec2f{slot_x.x, 0.0f} + slot_size * 0.5f);
+        vertex_array.setQuadColor(idx, color);
+    }
+
+    [[nodiscard]]
+    sf::Color getSlotColor(size_t const slot_idx) const
+    {
+        return (*activities)[history->entries.activities[slot_idx]].color;
+    }
+
+    /// Converts a time in milliseconds since epoch to seconds since the start of the day
+    [[nodiscard]]
+    float getDayTime(int64_t const time_ms) const
+    {
+        return static_cast<float>(time_ms - history->getDayStart()) * 0.001f;
+    }
+
     [[nodiscard]]
     Vec2f getAvailableSize() const
     {
@@ -117,32 +194,14 @@ private:
     [[nodiscard]]
     std::optional<SlotHover> getSlotHover(float const x) const
     {
-        size_t const entry_count = history->entries.size();
         Vec2f const available_size = getAvailableSize();
         float constexpr day_seconds = 3600.0f * 24.0f;
 
-        auto const getSlotRangeX = [&](float const start_time, float const end_time) {
-            float const  x_start   = ui::element_spacing + available_size.x * (start_time / day_seconds);
-            float const  x_end     = ui::element_spacing + available_size.x * (end_time / day_seconds);
-            return Vec2f{x_start, x_end};
-        };
-
-        auto const& entries = history->entries;
-        // Check all entries except the last
-        for (size_t i = 0; i < entry_count - 1; ++i) {
-            Vec2f const start_end = {entries[i].date.getTimeAsSeconds(), entries[i + 1].date.getTimeAsSeconds()};
-            Vec2f const range     = getSlotRangeX(start_end.x, start_end.y);
-            if (x > range.x && x < range.y) {
-                return SlotHover{entries[i].activity_idx, x, start_end.x, start_end.y};
-            }
-        }
-        // Check the last (ongoing) one
-        Vec2f const start_end = {entries.back().date.getTimeAsSeconds(), Date::now().getTimeAsSeconds()};
-        Vec2f const last_range = getSlotRangeX(start_end.x, start_end.y);
-        if (x > last_range.x && x < last_range.y) {
-            return SlotHover{entries[entry_count - 1].activity_idx, x, start_end.x, start_end.y};
+        float const day_time = day_seconds * (x - ui::element_spacing) / available_size.x;
+        auto const slot = history->findSlot(history->getDayStart() + static_cast<int64_t>(day_time * 1000.0f));
+        if (!slot) {
+            return std::nullopt;
         }
-
-        return std::nullopt;
+        return SlotHover{slot->activity_idx, x, getDayTime(slot->start_ms), getDayTime(slot->end_ms)};
     }
 };
@@ -1,6 +1,8 @@
 #pragma once
 #include "peztool/utils/interpolation/standard_interpolated_value.hpp"
+#include "peztool/utils/render/text_run.hpp"
 #include "standard/widget.hpp"
+#include "utils.hpp"
 
 #include "./ui_common.hpp"
 #include "./day_overview_bar.hpp"
@@ -26,7 +28,30 @@ struct SlotInfo final : sf::Transformable, sf::Drawable
         : activities{&activities_}
         , font{font_}
         , background{s_size, ui::background_radius, {200, 200, 200}}
+        , m_name{font_, "", ui::info_box_title_size}
+        , m_duration{font_, "00:00:00", ui::info_box_value_size}
+        , m_start{font_, "00:00:00", ui::info_box_small_size}
+        , m_end{font_, "00:00:00", ui::info_box_small_size}
     {
+        float constexpr margin{2.0f * ui::element_spacing};
+        // Times are aligned as if all their digits had the same width
+        {
+            auto const bounds = m_duration.getLocalBounds();
+            m_duration.setOrigin(bounds.position + bounds.size * 0.5f);
+            m_duration.setPosition(s_size * 0.5f);
+        }
+        {
+            auto const bounds = m_start.getLocalBounds();
+            float const slot_times_y = s_size.y - margin;
+            m_start.setOrigin(bounds.position + Vec2f{0.0f, bounds.size.y});
+            m_start.setPosition({margin, slot_times_y});
+            m_end.setOrigin(bounds.position + Vec2f{bounds.size.x, bounds.size.y});
+            m_end.setPosition({s_size.x - margin, slot_times_y});
+        }
+        m_name.setPosition({s_size.x * 0.5f, margin});
+        m_start.setFillColor(pez::setAlpha(sf::Color::White, 150));
+        m_end.setFillColor(pez::setAlpha(sf::Color::White, 150));
+
         setOrigin({s_size.x * 0.5f, 0.0f});
         background.setShadowSize(40.0f);
         background.shadow_offset = {0.0f, 10.0f};
@@ -47,45 +72,10 @@ struct SlotInfo final : sf::Transformable, sf::Drawable
     {
         states.transform *= getTransform();
         target.draw(background, states);
-
-        float const margin{2.0f * ui::element_spacing};
-
-        Activity const& current_activity = (*activities)[current_hover.activity_idx];
-
-        sf::Text text{font, current_activity.name, ui::info_box_title_size};
-        ui::setOrigin(text, ui::origin::Mode::TopCenter);
-        text.setPosition({s_size.x * 0.5f, margin});
-        target.draw(text, states);
-
-        text.setCharacterSize(ui::info_box_value_size);
-        text.setFillColor(current_hover.activity_idx > 0 ? current_activity.color : sf::Color{220, 220, 220});
-        {
-            text.setString("00:00:00");
-            auto const bounds = text.getLocalBounds();
-            text.setString(timeToString(current_hover.end_time - current_hover.start_time));
-            text.setOrigin(bounds.position + bounds.size * 0.5f);
-        }
-        text.setPosition(s_size * 0.5f);
-        target.draw(text, states);
-        text.setCharacterSize(ui::info_box_small_size);
-        text.setFillColor(pez::setAlpha(sf::Color::White, 150));
-
-        {
-            text.setString("00:00:00");
-            auto const bounds = text.getLocalBounds();
-            float const slot_times_y = s_size.y - margin;
-            text.setPosition({margin, slot_times_y});
-
-            text.setString(timeToString(current_hover.start_time));
-            text.setOrigin(bounds.position + Vec2f{0.0f, bounds.size.y});
-            target.draw(text, states);
-
-            text.setString(timeToString(current_hover.end_time));
-            text.setPosition({s_size.x - margin, slot_times_y});
-            text.setOrigin(bounds.position + Vec2f{bounds.size.x, bounds.size.y});
-            target.draw(text, states);
-        }
-
+        target.draw(m_name, states);
+        target.draw(m_duration, states);
+        target.draw(m_start, states);
+        target.draw(m_end, states);
     }
 
     void setHover(DayOverviewBar::SlotHover const& hover, Vec2f const position_)
@@ -93,10 +83,18 @@ struct SlotInfo final : sf::Transformable, sf::Drawable
         if (hover.x != current_hover.x) {
             position.setValueDirect(position_);
             current_hover = hover;
+            updateLabels();
             setVisible(true);
         }
     }
 
+    /// Returns the area covered by the background once fully shown
+    [[nodiscard]]
+    sf::FloatRect getFullBounds() const
+    {
+        return {getPosition() - getOrigin(), s_size};
+    }
+
     void setVisible(bool const v)
     {
         if (v != visible) {
@@ -109,4 +107,23 @@ struct SlotInfo final : sf::Transformable, sf::Drawable
             scale = 0.0f;
         }
     }
+
+private:
+    pez::TextRun m_name;
+    pez::TextRun m_duration;
+    pez::TextRun m_start;
+    pez::TextRun m_end;
+    LabelBuffer  m_buffer{};
+
+    void updateLabels()
+    {
+        Activity const& current_activity = (*activities)[current_hover.activity_idx];
+        m_name.setString(current_activity.name);
+        ui::setOrigin(m_name, ui::origin::Mode::TopCenter);
+
+        m_duration.setFillColor(current_hover.activity_idx > 0 ? current_activity.color : sf::Color{220, 220, 220});
+        m_duration.setString(timeToString(current_hover.end_time - current_hover.start_time, m_buffer));
+        m_start.setString(timeToString(current_hover.start_time, m_buffer));
+        m_end.setString(timeToString(current_hover.end_time, m_buffer));
+    }
 };
@@ -29,7 +29,7 @@ struct Button : ui::Widget
         float constexpr label_margin = 20.0f;
         text_label.setFillColor(ui::subtitle_color);
         ui::setOrigin(text_label, ui::origin::Mode::Center);
-        size = {text_label.getLocalBounds().size + 2.0f * Vec2f{label_margin, label_margin}};
+        setSize(text_label.getLocalBounds().size + 2.0f * Vec2f{label_margin, label_margin});
         text_label.setPosition(*size * 0.5f);
 
         background.setShadowSize(ui::background_shadow * 0.5f);
@@ -51,9 +51,13 @@ struct Button : ui::Widget
 
     }
 
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
+    {
+        batch.add(background, transform);
+    }
+
     void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
     {
-        target.draw(background, states);
         target.draw(text_label, states);
     }
 
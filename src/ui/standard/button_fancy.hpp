@@ -43,15 +43,9 @@ struct ButtonFancy : Button
         });
     }
 
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
-    {
-        target.draw(background, states);
-        target.draw(text_label, states);
-    }
-
     void setSize(sf::Vector2f const& size_)
     {
-        size = size_;
+        Widget::setSize(size_);
 
         background.setSize(size_);
         background.setPosition(size_ * 0.5f);
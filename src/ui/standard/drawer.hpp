@@ -189,11 +189,11 @@ private:
         switch (side) {
             case Side::Top:
             case Side::Bottom:
-                size = {widget->size->x, widget->size->y + pull_length};
+                setSize({widget->size->x, widget->size->y + pull_length});
                 break;
             case Side::Left:
             case Side::Right:
-                size = {widget->size->x + pull_length, widget->size->y};
+                setSize({widget->size->x + pull_length, widget->size->y});
                 break;
         }
     }
@@ -65,10 +65,13 @@ struct RadioButton final : ui::Widget
         background.setFillColor(background_color);
     }
 
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
     {
-        target.draw(background, states);
+        batch.add(background, transform);
+    }
 
+    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    {
         float constexpr state_padding = 4.0f;
         float const state_radius = (s_radius - state_padding) * state_scale;
         sf::CircleShape toggle_status;
@@ -2,6 +2,7 @@
 #include "./widget.hpp"
 #include "peztool/utils/interpolation/standard_interpolated_value.hpp"
 #include "peztool/utils/render/card/card_outlined.hpp"
+#include "peztool/utils/render/text_run.hpp"
 
 
 struct TextLabel final : ui::Widget
@@ -16,21 +17,27 @@ struct TextLabel final : ui::Widget
         m_text.setScale(s_quality_scale_vec_inv);
     }
 
-    void setString(std::string const& str)
+    void setString(std::string_view const str)
     {
+        if (m_text.getString() == str) {
+            return;
+        }
         m_text.setString(str);
         updateSize();
+        markDirty();
     }
 
     void setCharacterSize(int32_t const char_size)
     {
-        m_text.setCharacterSize(static_cast<int32_t>(static_cast<float>(char_size) * s_quality_scale));
+        m_text.setCharacterSize(static_cast<uint32_t>(static_cast<float>(char_size) * s_quality_scale));
         updateSize();
+        markDirty();
     }
 
     void setFillColor(sf::Color const color)
     {
         m_text.setFillColor(color);
+        markDirty();
     }
 
     void onUpdate(float const) override
@@ -48,12 +55,12 @@ private:
     static constexpr Vec2f s_quality_scale_vec = {s_quality_scale, s_quality_scale};
     static constexpr Vec2f s_quality_scale_vec_inv = {s_quality_scale_inv, s_quality_scale_inv};
 
-    sf::Text m_text;
+    pez::TextRun m_text;
 
     void updateSize()
     {
         auto const bounds = m_text.getLocalBounds();
-        size = bounds.size * s_quality_scale_inv;
+        setSize(bounds.size * s_quality_scale_inv);
         m_text.setOrigin(bounds.position);
     }
 };
\ No newline at end of file
@@ -96,10 +96,13 @@ struct Toggle final : ui::Widget
         //background.setFillColor(background_color);
     }
 
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
     {
-        target.draw(background, states);
+        batch.add(background, transform);
+    }
 
+    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    {
         sf::CircleShape toggle_status;
         float constexpr state_radius{s_radius + 0.1f};
         toggle_status.setRadius(state_radius);
@@ -1,6 +1,16 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <memory>
+#include <vector>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/Sprite.hpp>
 #include "peztool/utils/vec.hpp"
+#include "peztool/utils/render/card/card_batch.hpp"
+#include "peztool/utils/render/draw_calls.hpp"
+#include "peztool/utils/grid.hpp"
+#include "peztool/utils/interpolation/interpolable.hpp"
 #include "origin.hpp"
 
 namespace ui
@@ -11,7 +21,7 @@ struct Widget : sf::Drawable, sf::Transformable
     /// Shorthand for handle to widget
     using Ptr = std::shared_ptr<Widget>;
 
-    /// The widget's size
+    /// The widget's size, changed with setSize so that the parent's child index follows
     std::optional<Vec2f> size = std::nullopt;
     /// Children widgets
     std::vector<Ptr> children;
@@ -29,16 +39,107 @@ struct Widget : sf::Drawable, sf::Transformable
 
     void attach(Ptr const& child)
     {
+        child->m_parent = this;
         children.push_back(child);
+        m_child_index_valid = false;
+        markDirty();
     }
 
     template<typename TWidget>
     std::shared_ptr<TWidget> attachTyped(std::shared_ptr<TWidget> const& child)
     {
-        children.push_back(child);
+        attach(child);
         return child;
     }
 
+    /// Flags the widget as changed, the cached renders of the widget and its ancestors will be refreshed
+    void markDirty()
+    {
+        m_dirty = true;
+        ++m_generation;
+        if (m_parent) {
+            m_parent->markDirty();
+        }
+    }
+
+    [[nodiscard]]
+    bool isDirty() const
+    {
+        return m_dirty;
+    }
+
+    /// Changes each time this widget or one of its children is marked dirty
+    [[nodiscard]]
+    uint64_t getGeneration() const
+    {
+        return m_generation;
+    }
+
+    /** Renders the subtree once in a texture and draws it as a single sprite until it is marked dirty
+     *
+     * @param padding Space kept around the widget's size for what is drawn outside of it, like shadows
+     */
+    void enableCache(float const padding)
+    {
+        m_cache = std::make_unique<sf::RenderTexture>();
+        m_cache_padding = padding;
+        markDirty();
+    }
+
+    /// The widget will be redrawn as long as this interpolation is running
+    void trackInterpolation(pez::Interpolable const& interpolation)
+    {
+        m_interpolations.push_back(&interpolation);
+    }
+
+    void setPosition(Vec2f const position)
+    {
+        sf::Transformable::setPosition(position);
+        onTransformChanged();
+    }
+
+    void setScale(Vec2f const scale)
+    {
+        sf::Transformable::setScale(scale);
+        onTransformChanged();
+    }
+
+    void setOrigin(Vec2f const origin)
+    {
+        sf::Transformable::setOrigin(origin);
+        onTransformChanged();
+    }
+
+    void setRotation(sf::Angle const angle)
+    {
+        sf::Transformable::setRotation(angle);
+        onTransformChanged();
+    }
+
+    void move(Vec2f const offset)
+    {
+        sf::Transformable::move(offset);
+        onTransformChanged();
+    }
+
+    void scale(Vec2f const factor)
+    {
+        sf::Transformable::scale(factor);
+        onTransformChanged();
+    }
+
+    void rotate(sf::Angle const angle)
+    {
+        sf::Transformable::rotate(angle);
+        onTransformChanged();
+    }
+
+    void setSize(Vec2f const size_)
+    {
+        size = size_;
+        onTransformChanged();
+    }
+
     void setOriginMode(origin::Mode const origin)
     {
         setOrigin(getOriginPosition(origin));
@@ -56,27 +157,35 @@ struct Widget : sf::Drawable, sf::Transformable
     }
 
     /// The top level draw method, should not be called manually
-    void draw(sf::RenderTarget& target, sf::RenderStates states) const override
+    void draw(sf::RenderTarget& target, sf::RenderStates const states) const override
     {
-        if (!m_visible) {
-            return;
-        }
-        // Apply local transform
-        states.transform *= getTransform();
-        // Draw this widget first
-        onDraw(target, states);
-        // Then draw its children
-        for (auto& child : children) {
-            child->draw(target, states);
-        }
+        drawWidget(target, states, m_card_batch ? *m_card_batch : s_card_batch, false);
     }
 
-    /// The widget specific draw
+    /// The widget specific draw, called after the cards of the widget are drawn
     virtual void onDraw(sf::RenderTarget& target, sf::RenderStates states) const
     {
 
     }
 
+    /** Adds the cards drawn below the content of the widget to @p batch
+     *
+     * The cards of sibling widgets are drawn together with one draw for their shadows and one for
+     * their fills, so like the widgets themselves they should not overlap.
+     *
+     * @param transform The transform of the widget in the batch
+     */
+    virtual void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const
+    {
+
+    }
+
+    /// Sets the batch used to draw the cards of this widget and its descendants
+    void setCardBatch(pez::CardBatch& batch)
+    {
+        m_card_batch = &batch;
+    }
+
     /// Checks if the provided position is within the widget
     [[nodiscard]]
     bool contains(Vec2f const pos) const
@@ -87,6 +196,7 @@ struct Widget : sf::Drawable, sf::Transformable
 
     void mouseEnter()
     {
+        markDirty();
         onMouseEnter();
     }
 
@@ -96,6 +206,7 @@ struct Widget : sf::Drawable, sf::Transformable
             active->mouseExit();
             active = nullptr;
         }
+        markDirty();
         onMouseExit();
     }
 
@@ -117,17 +228,40 @@ struct Widget : sf::Drawable, sf::Transformable
 
         // Not using an else because active may have been invalidated during previous if
         if (!active) {
-            // Currently not taking order into account. Should be last checked first but I will
-            // assume that there is no overlap
-            for (auto const& child : children) {
-                if (child->contains(local_pos)) {
-                    active = child;
-                    active->mouseEnter();
-                    active->mouseMove(local_pos);
-                    break;
-                }
+            active = findChild(local_pos);
+            if (active) {
+                active->mouseEnter();
+                active->mouseMove(local_pos);
+            }
+        }
+    }
+
+    /** Returns the child containing @p pos, if any
+     *
+     * Currently not taking order into account, the first child in the list wins. Children are
+     * assumed not to overlap.
+     *
+     * @param pos The position relative to the widget's position
+     */
+    [[nodiscard]]
+    Ptr findChild(Vec2f const pos) const
+    {
+        updateChildIndex();
+        Vec2f const cell = (pos - m_child_index_origin).componentWiseDiv(m_child_index_cell_size);
+        if (cell.x < 0.0f || cell.y < 0.0f) {
+            return nullptr;
+        }
+        auto const cell_x = static_cast<int32_t>(cell.x);
+        auto const cell_y = static_cast<int32_t>(cell.y);
+        if (cell_x >= m_child_index.width || cell_y >= m_child_index.height) {
+            return nullptr;
+        }
+        for (uint32_t const child_idx : m_child_index.get(cell_x, cell_y)) {
+            if (children[child_idx]->contains(pos)) {
+                return children[child_idx];
             }
         }
+        return nullptr;
     }
 
     bool click(Vec2f const pos)
@@ -140,6 +274,9 @@ struct Widget : sf::Drawable, sf::Transformable
             }
         }
         m_clicked = onClick(local_pos);
+        if (m_clicked) {
+            markDirty();
+        }
         return m_clicked;
     }
 
@@ -152,6 +289,7 @@ struct Widget : sf::Drawable, sf::Transformable
         }
         if (m_clicked) {
             m_clicked = false;
+            markDirty();
             onUnclick(local_pos);
         }
         mouseMove(pos);
@@ -208,6 +346,12 @@ struct Widget : sf::Drawable, sf::Transformable
     void update(float const dt)
     {
         onUpdate(dt);
+        for (auto const* interpolation : m_interpolations) {
+            if (!interpolation->isDone()) {
+                markDirty();
+                break;
+            }
+        }
         for (auto const& child : children) {
             child->update(dt);
         }
@@ -226,7 +370,10 @@ struct Widget : sf::Drawable, sf::Transformable
 
     void setVisible(bool const visible)
     {
-        m_visible = visible;
+        if (visible != m_visible) {
+            m_visible = visible;
+            markDirty();
+        }
     }
 
     void setChildrenVisibility(bool const visible) const
@@ -259,10 +406,182 @@ private:
     bool m_descendant_clicked = false;
     bool m_visible = true;
 
+    Widget* m_parent = nullptr;
+    /// Inverse of the local transform, kept until the transform changes
+    mutable sf::Transform m_inverse_transform;
+    mutable bool m_inverse_transform_valid = false;
+    /// Uniform grid over the children bounds, each cell lists the children overlapping it
+    mutable pez::Grid<std::vector<uint32_t>> m_child_index;
+    mutable Vec2f m_child_index_origin;
+    mutable Vec2f m_child_index_cell_size{1.0f, 1.0f};
+    mutable bool m_child_index_valid = false;
+    /// Set when something changed since the last draw
+    mutable bool m_dirty = true;
+    uint64_t m_generation = 0;
+    /// Interpolations that keep the widget dirty while running
+    std::vector<pez::Interpolable const*> m_interpolations;
+
+    /// Render of the subtree, only used if caching is enabled
+    mutable std::unique_ptr<sf::RenderTexture> m_cache;
+    float m_cache_padding = 0.0f;
+
+    /// Batch of the cards of the tree, only set on the root
+    pez::CardBatch* m_card_batch = nullptr;
+    /// Used by the trees drawn without a batch, widgets are only drawn from the main thread
+    static inline pez::CardBatch s_card_batch;
+
+    /// @param cards_drawn True if the parent already drew the cards of this widget with the ones of its siblings
+    void drawWidget(sf::RenderTarget& target, sf::RenderStates states, pez::CardBatch& batch, bool const cards_drawn) const
+    {
+        if (!m_visible) {
+            return;
+        }
+        // Apply local transform
+        states.transform *= getTransform();
+        if (m_cache) {
+            drawCached(target, states, batch);
+            return;
+        }
+        if (!cards_drawn) {
+            onDrawCards(batch, states.transform);
+            flushCards(target, states, batch);
+        }
+        drawSubtree(target, states, batch);
+    }
+
+    void drawSubtree(sf::RenderTarget& target, sf::RenderStates const& states, pez::CardBatch& batch) const
+    {
+        // Draw this widget first
+        onDraw(target, states);
+        // Children do not overlap, the cards of all of them are drawn before their content
+        for (auto const& child : children) {
+            if (child->m_visible && !child->m_cache) {
+                child->onDrawCards(batch, states.transform * child->getTransform());
+            }
+        }
+        flushCards(target, states, batch);
+        // Then draw their content, cached children draw their own cards in their cache
+        for (auto const& child : children) {
+            child->drawWidget(target, states, batch, true);
+        }
+        m_dirty = false;
+    }
+
+    /// Draws the cards in @p batch, their vertices already have the widget transform applied
+    static void flushCards(sf::RenderTarget& target, sf::RenderStates states, pez::CardBatch& batch)
+    {
+        if (batch.empty()) {
+            return;
+        }
+        states.transform = sf::Transform::Identity;
+        batch.flush(target, states);
+    }
+
+    void drawCached(sf::RenderTarget& target, sf::RenderStates states, pez::CardBatch& batch) const
+    {
+        Vec2f const padding{m_cache_padding, m_cache_padding};
+        if (m_dirty) {
+            auto const texture_size = static_cast<Vec2u>(size.value_or(Vec2f{}) + 2.0f * padding);
+            if (m_cache->getSize() != texture_size && !m_cache->resize(texture_size)) {
+                std::cout << "Cannot create widget cache texture" << std::endl;
+                m_cache.reset();
+                onDrawCards(batch, states.transform);
+                flushCards(target, states, batch);
+                drawSubtree(target, states, batch);
+                return;
+            }
+            m_cache->clear(sf::Color::Transparent);
+            sf::RenderStates cache_states;
+            cache_states.transform.translate(padding);
+            onDrawCards(batch, cache_states.transform);
+            flushCards(*m_cache, cache_states, batch);
+            drawSubtree(*m_cache, cache_states, batch);
+            m_cache->display();
+        }
+        // The cache holds colors already multiplied by their alpha
+        states.blendMode = sf::BlendMode{sf::BlendMode::Factor::One, sf::BlendMode::Factor::OneMinusSrcAlpha};
+        states.transform.translate(-padding);
+        target.draw(sf::Sprite{m_cache->getTexture()}, states);
+        pez::DrawCalls::add();
+    }
+
+    void onTransformChanged()
+    {
+        m_inverse_transform_valid = false;
+        // The bounds of this widget in its parent moved
+        if (m_parent) {
+            m_parent->m_child_index_valid = false;
+        }
+        markDirty();
+    }
+
     [[nodiscard]]
     Vec2f getLocalPoint(Vec2f const point) const
     {
-        return getTransform().getInverse().transformPoint(point);
+        if (!m_inverse_transform_valid) {
+            m_inverse_transform = getTransform().getInverse();
+            m_inverse_transform_valid = true;
+        }
+        return m_inverse_transform.transformPoint(point);
+    }
+
+    /// Rebuilds the children grid if a child was added or moved since the last lookup
+    void updateChildIndex() const
+    {
+        if (m_child_index_valid) {
+            return;
+        }
+        m_child_index_valid = true;
+        m_child_index.resize(0, 0);
+
+        // Bounds of the children in this widget's space, children without size cannot be hovered
+        std::vector<std::pair<uint32_t, sf::FloatRect>> bounds;
+        Vec2f bounds_min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+        Vec2f bounds_max{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+        auto const child_count = static_cast<uint32_t>(children.size());
+        for (uint32_t i{0}; i < child_count; ++i) {
+            auto const& child = children[i];
+            if (!child->size) {
+                continue;
+            }
+            sf::FloatRect const rect = child->getTransform().transformRect({{}, *child->size});
+            bounds.emplace_back(i, rect);
+            bounds_min = {std::min(bounds_min.x, rect.position.x), std::min(bounds_min.y, rect.position.y)};
+            bounds_max = {std::max(bounds_max.x, rect.position.x + rect.size.x), std::max(bounds_max.y, rect.position.y + rect.size.y)};
+        }
+        if (bounds.empty()) {
+            return;
+        }
+
+        // About one child per cell if they are evenly spread, the cells follow the aspect ratio of the
+        // bounds so that a single row of children gets a single row of cells
+        auto const child_count_f = static_cast<float>(bounds.size());
+        Vec2f const extent = {std::max(bounds_max.x - bounds_min.x, 1.0f), std::max(bounds_max.y - bounds_min.y, 1.0f)};
+        float const cols = std::clamp(std::round(std::sqrt(child_count_f * extent.x / extent.y)), 1.0f, child_count_f);
+        float const rows = std::ceil(child_count_f / cols);
+        Vec2i const cell_count{static_cast<int32_t>(cols), static_cast<int32_t>(rows)};
+        m_child_index.resize(cell_count.x, cell_count.y);
+        m_child_index_origin = bounds_min;
+        m_child_index_cell_size = {
+            std::max(extent.x / cols, 1.0f),
+            std::max(extent.y / rows, 1.0f)
+        };
+        auto const getCell = [this, cell_count](Vec2f const pos) {
+            Vec2f const cell = (pos - m_child_index_origin).componentWiseDiv(m_child_index_cell_size);
+            return Vec2i{
+                std::clamp(static_cast<int32_t>(cell.x), 0, cell_count.x - 1),
+                std::clamp(static_cast<int32_t>(cell.y), 0, cell_count.y - 1)
+            };
+        };
+        for (auto const& [child_idx, rect] : bounds) {
+            Vec2i const first = getCell(rect.position);
+            Vec2i const last  = getCell(rect.position + rect.size);
+            for (int32_t y{first.y}; y <= last.y; ++y) {
+                for (int32_t x{first.x}; x <= last.x; ++x) {
+                    m_child_index.get(x, y).push_back(child_idx);
+                }
+            }
+        }
     }
 };
 
@@ -3,6 +3,7 @@
 
 #include "./ui_common.hpp"
 #include "activity.hpp"
+#include "peztool/utils/render/card/card_batch.hpp"
 
 
 struct TimeBar final : ui::Widget
@@ -30,12 +31,16 @@ struct TimeBar final : ui::Widget
     std::vector<Activity> const* activities;
 
     std::vector<ActivityInfo> info;
+    /// Layout of the last redraw
+    std::vector<ActivityInfo> drawn_info;
 
     // Hover
     std::optional<ActivityHover> activity_hover;
 
     sf::Font const& font;
     pez::CardOutlined background;
+    /// One card per activity, reshaped when the layout changes
+    std::vector<pez::Card> slot_cards;
 
     explicit
     TimeBar(sf::Font const& font_, Vec2f const size_, History const& history_, std::vector<Activity> const& activities_)
@@ -43,9 +48,15 @@ struct TimeBar final : ui::Widget
         , history{&history_}
         , activities{&activities_}
         , info(activities->size())
+        , drawn_info(activities->size())
         , font{font_}
         , background{ui::createBackground(size_)}
     {
+        slot_cards.reserve(activities->size());
+        for (Activity const& activity : *activities) {
+            pez::Card& card = slot_cards.emplace_back(Vec2f{}, ui::background_radius - ui::element_spacing, activity.color);
+            card.shadow_offset = {0.0f, 2.0f};
+        }
     }
 
     void onUpdate(float const dt) override
@@ -64,29 +75,40 @@ struct TimeBar final : ui::Widget
 
         float const total_width = size->x - 2.0f * ui::element_spacing - static_cast<float>(slot_count - 1) * ui::element_spacing;
         float current_x = ui::element_spacing;
+        bool layout_changed = false;
         for (size_t i = 1; i < activity_count; ++i) {
             info[i].ratio = info[i].duration / total_time;
             info[i].width = info[i].ratio * total_width;
             info[i].x = current_x;
             current_x += info[i].width + ui::element_spacing;
+            // Sub-pixel changes are not worth a redraw
+            auto const& drawn = drawn_info[i];
+            layout_changed |= (std::abs(info[i].width - drawn.width) > 0.25f) || (std::abs(info[i].x - drawn.x) > 0.25f) || ((info[i].duration == 0.0f) != (drawn.duration == 0.0f));
+        }
+
+        if (layout_changed) {
+            drawn_info = info;
+            updateSlotCards();
+            markDirty();
         }
     }
 
-    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
     {
-        target.draw(background, states);
+        batch.add(background, transform);
+    }
 
-        float const height = size->y - 2.0f * ui::element_spacing;
-        for (auto const& a : info) {
-            Activity const& activity = (*activities)[a.activity_idx];
-            if (a.duration == 0.0f) {
-                continue;
+    void onDraw(sf::RenderTarget& target, sf::RenderStates const states) const override
+    {
+        // Slots do not overlap, they are drawn with one draw for the shadows and one for the fills
+        for (auto const& a : drawn_info) {
+            if (a.duration > 0.0f) {
+                m_slot_batch.add(slot_cards[a.activity_idx], states.transform);
             }
-            pez::Card time_slot{{a.width, height}, ui::background_radius - ui::element_spacing, activity.color};
-            time_slot.setPosition({a.x, ui::element_spacing});
-            time_slot.shadow_offset = {0.0f, 2.0f};
-            target.draw(time_slot, states);
         }
+        sf::RenderStates batch_states = states;
+        batch_states.transform = sf::Transform::Identity;
+        m_slot_batch.flush(target, batch_states);
     }
 
     bool onClick(Vec2f const) override
@@ -106,14 +128,33 @@ struct TimeBar final : ui::Widget
 
     void checkActivity(float const x)
     {
-        size_t const activity_count = info.size();
-        for (size_t i{0}; i < activity_count; ++i) {
-            auto const& a = info[i];
-            if (x > a.x && x < a.x + a.width) {
+        // Slots are laid out from left to right, the candidate is the last one starting before x
+        auto const it = std::partition_point(info.begin(), info.end(), [x](ActivityInfo const& a) {
+            return a.x < x;
+        });
+        if (it != info.begin()) {
+            auto const& a = *(it - 1);
+            if (x < a.x + a.width) {
                 activity_hover = {a.activity_idx, a.duration, a.ratio, x};
                 return;
             }
         }
         activity_hover = std::nullopt;
     }
+
+private:
+    /// Scratch batch, only kept to reuse its memory between draws
+    mutable pez::CardBatch m_slot_batch;
+
+    void updateSlotCards()
+    {
+        float const height = size->y - 2.0f * ui::element_spacing;
+        for (auto const& a : drawn_info) {
+            if (a.duration > 0.0f) {
+                pez::Card& card = slot_cards[a.activity_idx];
+                card.setSize({a.width, height});
+                card.setPosition({a.x, ui::element_spacing});
+            }
+        }
+    }
 };
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include "standard/widget.hpp"
+#include "peztool/core/render.hpp"
+#include "peztool/utils/render/quad_vertex_array.hpp"
+
+#include "./ui_common.hpp"
+#include "./history.hpp"
+#include "./history_catalog.hpp"
+
+/** Shows the whole history on a zoomable time axis, from a few minutes to several years.
+ *
+ * The visible range follows the world layer of the render context: at zoom 1 the timeline shows
+ * one day, the mouse wheel zooms and dragging pans. Past days are read from the level of detail
+ * pyramid of the history catalog, today's slots from the history.
+ */
+struct Timeline final : ui::Widget
+{
+    using Ptr = std::shared_ptr<Timeline>;
+
+    // Data
+    History const* history{};
+    HistoryCatalog* catalog{};
+    std::vector<Activity> const* activities;
+
+    // Render
+    pez::CardOutlined background;
+    /// The visible slots, only redrawn when the visible range or the data changes
+    sf::RenderTexture chart_texture;
+    /// The card showing the chart texture
+    pez::Card chart;
+
+    explicit Timeline(Vec2f const size_, History const& history_, HistoryCatalog& catalog_, std::vector<Activity> const& activities_)
+        : ui::Widget{size_}
+        , history{&history_}
+        , catalog{&catalog_}
+        , activities{&activities_}
+        , background{ui::createBackground(size_)}
+    {
+        auto const texture_size = static_cast<Vec2u>(getAvailableSize());
+        if (!chart_texture.resize(texture_size)) {
+            std::cout << "Unable to create timeline texture" << std::endl;
+        }
+
+        chart.setShape(getAvailableSize(), ui::background_radius - ui::element_spacing);
+        chart.setColor(sf::Color::White);
+        chart.setTexture(&chart_texture.getTexture());
+        chart.shadow_offset = {0.0f, 2.0f};
+        chart.setPosition({ui::element_spacing, ui::element_spacing});
+
+        // Zoom 1 shows today
+        m_anchor_ms = history->getDayStart() + day_ms / 2;
+    }
+
+    /// Updates the visible range from the @p layer view, only the horizontal part of the view is used
+    void setView(pez::Layer const& layer)
+    {
+        // The layer zoom is not bounded, the span stays between one second per pixel and a few decades
+        double const width_px    = static_cast<double>(getAvailableSize().x);
+        double const ms_per_unit = static_cast<double>(day_ms) / width_px;
+        double const span_ms     = std::clamp(static_cast<double>(day_ms) / static_cast<double>(layer.getZoom()), width_px * 1000.0, max_span_ms);
+        double const center_ms   = std::clamp(static_cast<double>(m_anchor_ms) + static_cast<double>(layer.offset.x) * ms_per_unit,
+                                              static_cast<double>(m_anchor_ms) - max_span_ms, static_cast<double>(m_anchor_ms) + max_span_ms);
+        m_begin_ms = static_cast<int64_t>(center_ms - 0.5 * span_ms);
+        m_end_ms   = static_cast<int64_t>(center_ms + 0.5 * span_ms);
+    }
+
+    void onUpdate(float const dt) override
+    {
+        updateCatalog();
+
+        // Today's slots grow, the chart is only redrawn when the ongoing slot covers new pixels
+        int64_t const now_ms = Date::nowEpochMs();
+        double const ms_per_pixel = getMsPerPixel();
+        if (ms_per_pixel <= 0.0) {
+            return;
+        }
+        auto const now_pixel = static_cast<int64_t>(static_cast<double>(now_ms - m_begin_ms) / ms_per_pixel);
+        bool const now_visible = m_begin_ms < now_ms && history->getDayStart() < m_end_ms;
+        bool const range_changed = m_begin_ms != m_drawn_begin_ms || m_end_ms != m_drawn_end_ms;
+        if (!range_changed && !m_catalog_changed && (!now_visible || now_pixel == m_drawn_now_pixel)) {
+            return;
+        }
+        m_drawn_begin_ms  = m_begin_ms;
+        m_drawn_end_ms    = m_end_ms;
+        m_drawn_now_pixel = now_pixel;
+        m_catalog_changed = false;
+
+        generateSlots(now_ms);
+        chart_texture.clear({50, 50, 50});
+        chart_texture.draw(m_vertex_array);
+        pez::DrawCalls::add();
+        chart_texture.display();
+        markDirty();
+    }
+
+    void onDrawCards(pez::CardBatch& batch, sf::Transform const& transform) const override
+    {
+        batch.add(background, transform);
+    }
+
+    void onDraw(sf::RenderTarget& target, sf::RenderStates states) const override
+    {
+        states.texture = nullptr;
+        target.draw(chart, states);
+    }
+
+    /// Returns the number of quads of the current chart, bounded by its width in pixels
+    [[nodiscard]]
+    size_t getQuadCount() const
+    {
+        return m_quad_count;
+    }
+
+private:
+    static int64_t constexpr day_ms = 24 * 3600 * 1000;
+    /// About 50 years
+    static constexpr double max_span_ms = 50.0 * 365.25 * static_cast<double>(day_ms);
+
+    /// The time shown at the center with no offset
+    int64_t m_anchor_ms{0};
+    /// Visible range in milliseconds since epoch
+    int64_t m_begin_ms{0};
+    int64_t m_end_ms{day_ms};
+
+    /// What the current chart was drawn from
+    int64_t m_drawn_begin_ms{-1};
+    int64_t m_drawn_end_ms{-1};
+    int64_t m_drawn_now_pixel{-1};
+
+    /// Set when the catalog finished loading, the past days have to be redrawn
+    bool m_catalog_changed{false};
+    bool m_catalog_merged{false};
+
+    pez::QuadVertexArray m_vertex_array;
+    size_t               m_quad_count{0};
+    /// Pixel range and activity of the last quad, used to merge slots narrower than a pixel
+    int64_t              m_last_start_pixel{0};
+    int64_t              m_last_pixel{0};
+    uint16_t             m_last_activity{0};
+
+    /// Reloads the catalog when a new day starts since the day that just ended is only in the files
+    void updateCatalog()
+    {
+        bool const merged = catalog->isMerged();
+        if (merged && catalog->getPyramid().getEnd() != history->getDayStart()) {
+            catalog->load(history->getDayStart());
+        }
+        if (merged != m_catalog_merged) {
+            m_catalog_merged  = merged;
+            m_catalog_changed = true;
+        }
+    }
+
+    void generateSlots(int64_t const now_ms)
+    {
+        m_vertex_array.clear();
+        m_quad_count = 0;
+        m_last_pixel = std::numeric_limits<int64_t>::min();
+
+        double const ms_per_pixel = getMsPerPixel();
+        // The pyramid is being built while the catalog loads
+        if (catalog->isMerged()) {
+            catalog->getPyramid().foreachRun(m_begin_ms, m_end_ms, ms_per_pixel, [this](int64_t const start_ms, int64_t const end_ms, uint16_t const activity_idx) {
+                appendSlot(start_ms, end_ms, activity_idx);
+            });
+        }
+
+        // Today is small enough to be read directly, slots narrower than a pixel are merged while appending
+        TimeSeries const& entries = history->entries;
+        size_t const entry_count = entries.size();
+        auto const first = std::upper_bound(entries.times_ms.begin(), entries.times_ms.end(), m_begin_ms);
+        size_t i = (first == entries.times_ms.begin()) ? 0 : static_cast<size_t>(std::distance(entries.times_ms.begin(), first)) - 1;
+        for (; i < entry_count && entries.times_ms[i] < m_end_ms; ++i) {
+            int64_t const end_ms = (i + 1 < entry_count) ? entries.times_ms[i + 1] : now_ms;
+            appendSlot(entries.times_ms[i], end_ms, entries.activities[i]);
+        }
+    }
+
+    /// Appends a slot, merges it with the previous quad if it does not cover a new pixel or has the same activity
+    void appendSlot(int64_t const start_ms, int64_t const end_ms, uint16_t const activity_idx)
+    {
+        double const ms_per_pixel = getMsPerPixel();
+        auto const toPixel = [this, ms_per_pixel](int64_t const time_ms) {
+            double const pixel = std::round(static_cast<double>(time_ms - m_begin_ms) / ms_per_pixel);
+            return static_cast<int64_t>(std::clamp(pixel, 0.0, static_cast<double>(getAvailableSize().x)));
+        };
+        int64_t const end_pixel = toPixel(end_ms);
+        if (end_pixel <= m_last_pixel) {
+            return;
+        }
+        int64_t const start_pixel = std::max(toPixel(start_ms), m_last_pixel);
+        if (m_quad_count > 0 && start_pixel == m_last_pixel && activity_idx == m_last_activity) {
+            setQuad(m_quad_count - 1, m_last_start_pixel, end_pixel);
+        } else {
+            m_vertex_array.appendQuad();
+            setQuad(m_quad_count, start_pixel, end_pixel);
+            m_vertex_array.setQuadColor(m_quad_count, getActivityColor(activity_idx));
+            m_last_start_pixel = start_pixel;
+            ++m_quad_count;
+        }
+        m_last_pixel    = end_pixel;
+        m_last_activity = activity_idx;
+    }
+
+    void setQuad(size_t const quad_idx, int64_t const start_pixel, int64_t const end_pixel)
+    {
+        Vec2f const slot_size = {static_cast<float>(end_pixel - start_pixel), getAvailableSize().y};
+        m_vertex_array.createAlignedRectangle(quad_idx, slot_size, Vec2f{static_cast<float>(start_pixel), 0.0f} + slot_size * 0.5f);
+    }
+
+    [[nodiscard]]
+    sf::Color getActivityColor(uint16_t const activity_idx) const
+    {
+        // Old entries can reference activities that were removed from the configuration
+        if (activity_idx < activities->size()) {
+            return (*activities)[activity_idx].color;
+        }
+        return {100, 100, 100};
+    }
+
+    [[nodiscard]]
+    double getMsPerPixel() const
+    {
+        return static_cast<double>(m_end_ms - m_begin_ms) / static_cast<double>(getAvailableSize().x);
+    }
+
+    [[nodiscard]]
+    Vec2f getAvailableSize() const
+    {
+        float constexpr total_space = 2.0f * ui::element_spacing;
+        return *size - Vec2f{total_space, total_space};
+    }
+};
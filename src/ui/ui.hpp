@@ -6,6 +6,7 @@
 #include "./day_overview_bar.hpp"
 #include "./slot_info.hpp"
 #include "./time_bar.hpp"
+#include "./timeline.hpp"
 #include "configuration.hpp"
 #include "peztool/core/system.hpp"
 #include "peztool/utils/render/blur/blur.hpp"
@@ -24,16 +25,20 @@ using RendererUI = pez::Renderer<EntitiesUI, ProcessorsUI, RenderersUI>;
 struct UI final : RendererUI
 {
     static float constexpr time_bar_height = 100.0f;
+    static float constexpr timeline_height = 60.0f;
 
     History& history = pez::Singleton<History>::get();
+    HistoryCatalog& catalog = pez::Singleton<HistoryCatalog>::get();
     Configuration const& configuration = pez::Singleton<Configuration>::get();
 
     sf::Font const& font;
 
     ui::Widget::Ptr root;
     TextLabel::Ptr time_label;
+    LabelBuffer time_buffer{};
     TimeBar::Ptr time_bar_global;
     DayOverviewBar::Ptr day_overview_bar;
+    Timeline::Ptr timeline;
 
     std::vector<ActivityButton::Ptr> buttons;
     size_t current_activity{0};
@@ -42,6 +47,9 @@ struct UI final : RendererUI
     ActivityInfo activity_info;
 
     Blur background_blur;
+    /// What the current blur result was computed from
+    std::optional<sf::FloatRect> blur_region;
+    uint64_t blur_generation = 0;
 
     UI(Vec2f const render_size_, pez::ResourcesStore const& store_)
         : RendererUI{render_size_, store_}
@@ -54,7 +62,7 @@ struct UI final : RendererUI
         root = std::make_shared<ui::Widget>(m_render_size);
         // Initialize blur shaders
         CardShader::get().setRenderSize(m_render_size);
-        background_blur.kernel.setRadius(4.5f);
+        background_blur.setRadius(4.5f);
     }
 
     void onInitialized() override
@@ -64,15 +72,19 @@ struct UI final : RendererUI
 
     void render(pez::RenderContext& context) override
     {
+        timeline->setView(context.getWorldLayer());
         root->update(pez::App::getDt());
-        time_label->setString(timeToString(Date::now().getTimeAsSeconds()));
+        time_label->setString(timeToString(Date::now().getTimeAsSeconds(), time_buffer));
+        // The time label changes on the next wall clock second
+        pez::App::requestFrameIn(static_cast<float>(1000 - pez::App::getClock().getEpochMs() % 1000) * 0.001f);
+        // The cards of the widgets are drawn in batches, see Widget::onDrawCards
+        root->setCardBatch(context.getCardBatch());
         context.draw(*root);
 
         sf::RenderStates states;
 
         if (slot_info.scale > 0.0f || activity_info.scale > 0.0f) {
-            auto const& blur_texture = background_blur.apply(context);
-            states.texture = &blur_texture;
+            states.texture = &getBlurredBackground(context);
         }
 
         if (day_overview_bar->slot_hover) {
@@ -100,6 +112,41 @@ struct UI final : RendererUI
         context.draw(activity_info, states);
     }
 
+    /** Returns the blurred background behind the visible info boxes.
+     *
+     * Only the boxes area is blurred and the result is kept until the boxes move or the widgets
+     * below them change.
+     */
+    sf::Texture const& getBlurredBackground(pez::RenderContext& context)
+    {
+        std::optional<sf::FloatRect> region;
+        auto const addBounds = [&region](sf::FloatRect const bounds) {
+            if (!region) {
+                region = bounds;
+                return;
+            }
+            Vec2f const top_left{std::min(region->position.x, bounds.position.x), std::min(region->position.y, bounds.position.y)};
+            Vec2f const bottom_right{
+                std::max(region->position.x + region->size.x, bounds.position.x + bounds.size.x),
+                std::max(region->position.y + region->size.y, bounds.position.y + bounds.size.y)
+            };
+            region = sf::FloatRect{top_left, bottom_right - top_left};
+        };
+        if (slot_info.scale > 0.0f) {
+            addBounds(slot_info.getFullBounds());
+        }
+        if (activity_info.scale > 0.0f) {
+            addBounds(activity_info.getFullBounds());
+        }
+
+        if (region != blur_region || root->getGeneration() != blur_generation) {
+            blur_region = region;
+            blur_generation = root->getGeneration();
+            return background_blur.apply(context, *region);
+        }
+        return background_blur.getTexture();
+    }
+
     void initializeUI()
     {
         size_t const activity_count = configuration.activities.size();
@@ -117,11 +164,18 @@ struct UI final : RendererUI
 
         day_overview_bar = root->createChild<DayOverviewBar>(time_bar_size, history, configuration.activities);
         day_overview_bar->setPosition({ui::margin, current_y});
+        day_overview_bar->enableCache(ui::cache_padding);
         current_y += 1.0f * ui::margin + time_bar_height;
 
         time_bar_global = root->createChild<TimeBar>(font, time_bar_size, history, configuration.activities);
         time_bar_global->setPosition({ui::margin, current_y});
-        current_y += 1.5f * ui::margin + time_bar_height;
+        time_bar_global->enableCache(ui::cache_padding);
+        current_y += 1.0f * ui::margin + time_bar_height;
+
+        timeline = root->createChild<Timeline>(Vec2f{time_bar_size.x, timeline_height}, history, catalog, configuration.activities);
+        timeline->setPosition({ui::margin, current_y});
+        timeline->enableCache(ui::cache_padding);
+        current_y += 1.5f * ui::margin + timeline_height;
 
         Vec2f const activity_container_size = {
             m_render_size.x - 2.0f * ui::margin,
@@ -129,6 +183,7 @@ struct UI final : RendererUI
         };
         auto const activity_container = root->createChild<Container>(activity_container_size);
         activity_container->setPosition({ui::margin, current_y});
+        activity_container->enableCache(ui::cache_padding);
 
         auto const activity_count_f = static_cast<float>(activity_count);
         float const activity_height = activity_container_size.y - 2.0f * ui::margin;
@@ -138,11 +193,12 @@ struct UI final : RendererUI
             auto const activity_button = activity_container->createChild<ActivityButton>(m_resources, activity_size, i, history);
             float const x = ui::margin + static_cast<float>(i) * (activity_width + ui::margin);
             activity_button->setPosition({x, ui::margin});
+            activity_button->enableCache(ui::cache_padding);
             activity_button->on_activate = [this, i] {
                 activate(i);
             };
             activity_button->background.setFillColor(configuration.activities[i].color);
-            activity_button->background.activity_label = configuration.activities[i].name;
+            activity_button->background.setLabel(configuration.activities[i].name);
             buttons.push_back(activity_button);
         }
 
@@ -187,6 +243,6 @@ struct UI final : RendererUI
         buttons[current_activity]->deactivate();
         current_activity = activity_idx;
         buttons[current_activity]->activate();
-        history.addEntry(Date::now(), current_activity);
+        history.addEntry(Date::nowEpochMs(), current_activity);
     }
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include "peztool/utils/render/card/card_outlined.hpp"
+#include "peztool/utils/render/text_run.hpp"
 
 #include "./ui_configuration.hpp"
 #include "standard/widget.hpp"
@@ -18,7 +19,7 @@ inline pez::CardOutlined createBackground(Vec2f const size)
     return card;
 }
 
-inline void setOrigin(sf::Text& text, origin::Mode const mode)
+inline void setOrigin(pez::TextRun& text, origin::Mode const mode)
 {
     auto const bounds = text.getLocalBounds();
     text.setOrigin(origin::getPosition(mode, bounds.size) + bounds.position);
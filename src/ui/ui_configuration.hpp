@@ -7,6 +7,8 @@ namespace ui
 float constexpr outline_thickness = 0.0f;
 float constexpr background_radius = 20.0f;
 float constexpr background_shadow = 40.0f;
+/// Space around cached widgets to fit their shadows
+float constexpr cache_padding = 1.5f * background_shadow;
 Vec2f constexpr outline_vec{outline_thickness, outline_thickness};
 
 sf::Color constexpr background_color = {150, 150, 150};
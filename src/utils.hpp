@@ -1,5 +1,7 @@
 #pragma once
+#include <array>
 #include <filesystem>
+#include <format>
 #include <string_view>
 
 inline bool createIfDoesntExist(std::filesystem::path const& path)
@@ -22,16 +24,38 @@ inline void checkDataDirectory()
         // History might not be there for some reason
         createIfDoesntExist(history_dir_name);
     }
+    // Finished days are folded in yearly packs
+    createIfDoesntExist(data_dir_name / "archive");
     // The correct directories should be created at this point
 }
 
-inline std::string timeToString(float const seconds)
+/// Storage for formatted labels that are updated every frame
+using LabelBuffer = std::array<char, 32>;
+
+/// Formats @p seconds as HH:MM:SS in @p buffer without allocating
+inline std::string_view timeToString(float const seconds, LabelBuffer& buffer)
 {
     int32_t const minutes = static_cast<int32_t>(seconds) / 60;
     int32_t const hours   = minutes / 60;
-    return std::format(
+    auto const result = std::format_to_n(
+        buffer.data(),
+        buffer.size(),
         "{:0>2}:{:0>2}:{:0>2}",
         hours,
         minutes % 60,
         static_cast<int32_t>(seconds) % 60);
+    return {buffer.data(), static_cast<size_t>(result.out - buffer.data())};
+}
+
+/// Formats @p percent as a rounded percentage in @p buffer without allocating
+inline std::string_view percentToString(float const percent, LabelBuffer& buffer)
+{
+    auto const result = std::format_to_n(buffer.data(), buffer.size(), "{:.0f}%", percent);
+    return {buffer.data(), static_cast<size_t>(result.out - buffer.data())};
+}
+
+inline std::string timeToString(float const seconds)
+{
+    LabelBuffer buffer;
+    return std::string{timeToString(seconds, buffer)};
 }